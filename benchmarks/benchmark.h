@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+// Wall-clock milliseconds spent in function().
+template <typename Function>
+double time_ms(Function&& function) {
+  auto start = std::chrono::steady_clock::now();
+  std::forward<Function>(function)();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Best of `runs` timings, to keep one noisy run out of the report.
+template <typename Function>
+double best_ms(int runs, Function&& function) {
+  double best = time_ms(function);
+  for (int run = 1; run < runs; ++run) {
+    double elapsed = time_ms(function);
+    best = (elapsed < best ? elapsed : best);
+  }
+  return best;
+}
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+void keep(const T& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+inline void report(const char* name, double ms) {
+  std::printf("  %-40s %10.2f ms\n", name, ms);
+}
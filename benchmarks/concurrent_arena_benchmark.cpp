@@ -0,0 +1,89 @@
+// Small allocations from several threads at once: a shared ConcurrentArena
+// StackStorage, each thread's own for_this_thread() arena, and glibc
+// malloc. Every thread makes kAllocations allocations of 32 bytes; only the
+// allocation phase is timed. Build with -O2 -pthread.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "../stackallocator.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kAllocations = 1000000;
+constexpr size_t kBytes = 32;
+constexpr size_t kArenaBytes = 1 << 20;
+
+using SharedStorage =
+    StackStorage<kArenaBytes, NoArenaStats, ConcurrentArena>;
+using ThreadStorage = StackStorage<kArenaBytes>;
+
+// Runs allocate(thread, i) for every allocation on `threads` threads and
+// returns the time until all of them are done.
+template <typename Allocate>
+double run_threads(size_t threads, Allocate allocate) {
+  return time_ms([&] {
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&allocate, t] {
+        for (int i = 0; i < kAllocations; ++i) {
+          allocate(t, i);
+        }
+      });
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  });
+}
+
+}  // namespace
+
+int main() {
+  size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> counts;
+  for (size_t threads = 1; threads < hardware; threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(hardware);
+
+  std::printf("%d allocations of %zu bytes per thread, ms:\n", kAllocations,
+              kBytes);
+  std::printf("  threads %14s %14s %14s\n", "shared arena", "thread arena",
+              "malloc");
+  for (size_t threads : counts) {
+    std::vector<std::vector<void*>> blocks(
+        threads, std::vector<void*>(kAllocations));
+
+    double shared_ms;
+    {
+      SharedStorage storage(std::pmr::new_delete_resource());
+      shared_ms = run_threads(threads, [&](size_t t, int i) {
+        blocks[t][i] = storage.allocate(kBytes, alignof(void*));
+      });
+    }
+
+    double thread_ms = run_threads(threads, [&](size_t t, int i) {
+      blocks[t][i] = ThreadStorage::for_this_thread().allocate(
+          kBytes, alignof(void*));
+    });
+
+    double malloc_ms = run_threads(threads, [&](size_t t, int i) {
+      blocks[t][i] = std::malloc(kBytes);
+    });
+    for (std::vector<void*>& thread_blocks : blocks) {
+      for (void* block : thread_blocks) {
+        std::free(block);
+      }
+    }
+
+    std::printf("  %7zu %14.2f %14.2f %14.2f\n", threads, shared_ms,
+                thread_ms, malloc_ms);
+  }
+}
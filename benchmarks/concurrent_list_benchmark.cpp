@@ -0,0 +1,116 @@
+// Contention on a shared list at 1 to 64 pushing threads while one more
+// thread traverses it in a loop: ConcurrentList on std::allocator and on a
+// ConcurrentArena, against List behind a mutex. Pushers alternate seven
+// push_back() calls with one push_front(). Build with -O2 -pthread.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_list.h"
+#include "../stackallocator.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kPushes = 1 << 20;
+constexpr size_t kArenaBytes = 1 << 20;
+
+using SharedStorage =
+    StackStorage<kArenaBytes, NoArenaStats, ConcurrentArena>;
+using SharedAlloc =
+    StackAllocator<int, kArenaBytes, NoArenaStats, ConcurrentArena>;
+
+class LockedList {
+ public:
+  void push_back(int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.push_back(value);
+  }
+  void push_front(int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.push_front(value);
+  }
+  long long sum() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    long long sum = 0;
+    for (int value : list_) {
+      sum += value;
+    }
+    return sum;
+  }
+
+ private:
+  std::mutex mutex_;
+  List<int> list_;
+};
+
+template <typename T, typename Allocator>
+long long sum(ConcurrentList<T, Allocator>& list) {
+  long long sum = 0;
+  list.for_each([&sum](int value) { sum += value; });
+  return sum;
+}
+
+long long sum(LockedList& list) { return list.sum(); }
+
+// Splits kPushes between `threads` pushers and reports the push rate and
+// how many full traversals the reader finished meanwhile.
+template <typename Shared>
+void run(const char* name, Shared& list, int threads) {
+  std::atomic<int> running{threads};
+  size_t traversals = 0;
+  double ms = time_ms([&] {
+    std::thread reader([&] {
+      while (running.load(std::memory_order_acquire) > 0) {
+        keep(sum(list));
+        traversals++;
+      }
+    });
+    std::vector<std::thread> pushers;
+    for (int thread = 0; thread < threads; ++thread) {
+      pushers.emplace_back([&list, &running, threads] {
+        for (int i = 0; i < kPushes / threads; ++i) {
+          if (i % 8 == 0) {
+            list.push_front(i);
+          } else {
+            list.push_back(i);
+          }
+        }
+        running.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    for (std::thread& pusher : pushers) {
+      pusher.join();
+    }
+    reader.join();
+  });
+  std::printf("  %-33s %3d threads %8.2f M pushes/s %6zu traversals\n",
+              name, threads, kPushes / ms / 1000, traversals);
+}
+
+}  // namespace
+
+int main() {
+  std::printf("%d pushes split between the pushing threads, %u CPUs:\n",
+              kPushes, std::thread::hardware_concurrency());
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    {
+      ConcurrentList<int> list;
+      run("ConcurrentList", list, threads);
+    }
+    {
+      SharedStorage storage(std::pmr::new_delete_resource());
+      ConcurrentList<int, SharedAlloc> list{SharedAlloc(storage)};
+      run("ConcurrentList on ConcurrentArena", list, threads);
+    }
+    {
+      LockedList list;
+      run("List behind a mutex", list, threads);
+    }
+  }
+}
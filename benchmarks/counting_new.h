@@ -0,0 +1,52 @@
+#pragma once
+
+// Replaces the global allocation functions with ones that count calls.
+// Include from exactly one translation unit of a program.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<size_t> heap_allocations{0};
+
+void* operator new(size_t bytes) {
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer = std::malloc(bytes == 0 ? 1 : bytes)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes) { return operator new(bytes); }
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  size_t align = static_cast<size_t>(alignment);
+  size_t rounded = (bytes == 0 ? align : (bytes + align - 1) / align * align);
+  if (void* pointer = std::aligned_alloc(align, rounded)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+  return operator new(bytes, alignment);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+  std::free(pointer);
+}
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+  std::free(pointer);
+}
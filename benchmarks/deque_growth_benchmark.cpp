@@ -0,0 +1,80 @@
+// Heap allocations per million pushes into Deque for one-sided and
+// alternating traffic, with std::deque alongside for reference.
+// Build with -O2.
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+
+#include "../deque.h"
+#include "benchmark.h"
+#include "counting_new.h"
+
+namespace {
+
+constexpr int kPushes = 1000000;
+
+template <typename Container>
+void push_back_only(Container& container) {
+  for (int i = 0; i < kPushes; ++i) {
+    container.push_back(i);
+  }
+}
+
+template <typename Container>
+void push_front_only(Container& container) {
+  for (int i = 0; i < kPushes; ++i) {
+    container.push_front(i);
+  }
+}
+
+template <typename Container>
+void alternating_ends(Container& container) {
+  for (int i = 0; i < kPushes; ++i) {
+    if (i % 2 == 0) {
+      container.push_back(i);
+    } else {
+      container.push_front(i);
+    }
+  }
+}
+
+// A queue that stays around 4096 elements: push at the back, pop at the
+// front, so blocks keep draining at one end and filling at the other.
+template <typename Container>
+void sliding_queue(Container& container) {
+  for (int i = 0; i < kPushes; ++i) {
+    container.push_back(i);
+    if (container.size() > 4096) {
+      container.pop_front();
+    }
+  }
+}
+
+template <typename Container, typename Workload>
+void run(const char* name, Workload workload) {
+  size_t before = heap_allocations.load();
+  double ms = time_ms([&] {
+    Container container;
+    workload(container);
+    keep(container.size());
+  });
+  std::printf("  %-20s %10zu allocations %10.2f ms\n", name,
+              heap_allocations.load() - before, ms);
+}
+
+template <typename Container>
+void run_all(const char* container) {
+  std::printf("%s, %d pushes of int:\n", container, kPushes);
+  run<Container>("push_back only", push_back_only<Container>);
+  run<Container>("push_front only", push_front_only<Container>);
+  run<Container>("alternating ends", alternating_ends<Container>);
+  run<Container>("sliding queue", sliding_queue<Container>);
+}
+
+}  // namespace
+
+int main() {
+  run_all<Deque<int>>("Deque");
+  run_all<std::deque<int>>("std::deque");
+}
@@ -0,0 +1,65 @@
+// Iterator increment, decrement, indexing and strided access over 10M
+// elements of Deque, with std::deque and std::vector for reference.
+// Build with -O2.
+
+#include <cstdio>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "../deque.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kElements = 10000000;
+constexpr int kRuns = 5;
+
+template <typename Container>
+void run(const char* name) {
+  Container container;
+  for (int i = 0; i < kElements; ++i) {
+    container.push_back(i);
+  }
+  std::printf("%s, %d elements:\n", name, kElements);
+  report("++ over begin()..end()", best_ms(kRuns, [&] {
+           long long sum = 0;
+           auto last = container.end();
+           for (auto it = container.begin(); it != last; ++it) {
+             sum += *it;
+           }
+           keep(sum);
+         }));
+  report("-- over end()..begin()", best_ms(kRuns, [&] {
+           long long sum = 0;
+           auto first = container.begin();
+           for (auto it = container.end(); it != first;) {
+             --it;
+             sum += *it;
+           }
+           keep(sum);
+         }));
+  report("operator[]", best_ms(kRuns, [&] {
+           long long sum = 0;
+           for (size_t i = 0, size = container.size(); i < size; ++i) {
+             sum += container[i];
+           }
+           keep(sum);
+         }));
+  report("it += 7", best_ms(kRuns, [&] {
+           long long sum = 0;
+           auto last = container.begin() + (kElements / 7 * 7);
+           for (auto it = container.begin(); it != last; it += 7) {
+             sum += *it;
+           }
+           keep(sum);
+         }));
+}
+
+}  // namespace
+
+int main() {
+  run<Deque<int>>("Deque");
+  run<std::deque<int>>("std::deque");
+  run<std::vector<int>>("std::vector");
+}
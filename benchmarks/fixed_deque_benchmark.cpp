@@ -0,0 +1,90 @@
+// FixedDeque against the dynamic Deque: a bounded queue, short-lived
+// bursts, indexing and iteration, with the heap allocations each makes.
+// Build with -O2.
+
+#include <cstddef>
+#include <cstdio>
+
+#include "../deque.h"
+#include "../fixed_deque.h"
+#include "benchmark.h"
+#include "counting_new.h"
+
+namespace {
+
+constexpr size_t kCapacity = 1024;
+constexpr int kOperations = 10000000;
+constexpr int kBursts = 200000;
+constexpr int kBurstSize = 64;
+constexpr int kRuns = 3;
+
+template <typename Container, typename Workload>
+void run(const char* name, Workload workload) {
+  size_t before = heap_allocations.load();
+  double ms = best_ms(kRuns, workload);
+  std::printf("  %-36s %8.2f ms %10zu allocations\n", name, ms,
+              (heap_allocations.load() - before) / kRuns);
+}
+
+template <typename Container>
+void run_all(const char* name) {
+  std::printf("%s:\n", name);
+  run<Container>("queue of 1024, push_back/pop_front", [] {
+    Container queue;
+    long long sum = 0;
+    for (int i = 0; i < kOperations; ++i) {
+      if (queue.size() == kCapacity) {
+        sum += queue[0];
+        queue.pop_front();
+      }
+      queue.push_back(i);
+    }
+    keep(sum);
+  });
+  run<Container>("bursts of 64 on a fresh deque", [] {
+    long long sum = 0;
+    for (int burst = 0; burst < kBursts; ++burst) {
+      Container deque;
+      for (int i = 0; i < kBurstSize; ++i) {
+        if (i % 2 == 0) {
+          deque.push_back(i);
+        } else {
+          deque.push_front(i);
+        }
+      }
+      sum += deque[kBurstSize / 2];
+    }
+    keep(sum);
+  });
+  Container full;
+  for (size_t i = 0; i < kCapacity; ++i) {
+    full.push_front(static_cast<int>(i));
+  }
+  run<Container>("operator[] over 1024", [&full] {
+    long long sum = 0;
+    for (int round = 0; round < kOperations / static_cast<int>(kCapacity);
+         ++round) {
+      for (size_t i = 0; i < kCapacity; ++i) {
+        sum += full[i];
+      }
+    }
+    keep(sum);
+  });
+  run<Container>("iteration over 1024", [&full] {
+    long long sum = 0;
+    for (int round = 0; round < kOperations / static_cast<int>(kCapacity);
+         ++round) {
+      for (int value : full) {
+        sum += value;
+      }
+    }
+    keep(sum);
+  });
+}
+
+}  // namespace
+
+int main() {
+  run_all<FixedDeque<int, kCapacity>>("FixedDeque<int, 1024>");
+  run_all<Deque<int>>("Deque<int>");
+}
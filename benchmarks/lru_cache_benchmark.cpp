@@ -0,0 +1,118 @@
+// Hit rate and throughput of LruCache under Zipfian access (s = 0.99 over
+// 1M keys), on std::allocator and on a StackStorage, next to the usual
+// std::list + std::unordered_map cache. Each access is a get() followed by
+// a put() on a miss. Build with -O2.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory_resource>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../lru_cache.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr size_t kKeys = 1000000;
+constexpr size_t kAccesses = 10000000;
+constexpr double kSkew = 0.99;
+constexpr size_t kArenaBytes = 1 << 20;
+
+std::vector<uint64_t> zipfian_keys() {
+  std::vector<double> cdf(kKeys);
+  double total = 0;
+  for (size_t rank = 0; rank < kKeys; ++rank) {
+    total += 1.0 / std::pow(static_cast<double>(rank + 1), kSkew);
+    cdf[rank] = total;
+  }
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> uniform(0, total);
+  std::vector<uint64_t> keys(kAccesses);
+  for (uint64_t& key : keys) {
+    size_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) -
+                  cdf.begin();
+    // Scatter the ranks so that hot keys are not also small integers.
+    key = rank * 0x9E3779B97F4A7C15ULL;
+  }
+  return keys;
+}
+
+// The textbook cache that LruCache replaces.
+class ListMapCache {
+ public:
+  explicit ListMapCache(size_t capacity) : capacity_(capacity) {}
+
+  uint64_t* get(uint64_t key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    order_.splice(order_.begin(), order_, found->second);
+    return &found->second->second;
+  }
+  void put(uint64_t key, uint64_t value) {
+    if (order_.size() == capacity_) {
+      index_.erase(order_.back().first);
+      order_.pop_back();
+    }
+    order_.emplace_front(key, value);
+    index_[key] = order_.begin();
+  }
+
+ private:
+  size_t capacity_;
+  std::list<std::pair<uint64_t, uint64_t>> order_;
+  std::unordered_map<uint64_t,
+                     std::list<std::pair<uint64_t, uint64_t>>::iterator>
+      index_;
+};
+
+template <typename Cache>
+void run(const char* name, Cache& cache, const std::vector<uint64_t>& keys) {
+  size_t hits = 0;
+  double ms = time_ms([&] {
+    for (uint64_t key : keys) {
+      if (uint64_t* value = cache.get(key)) {
+        hits++;
+        keep(*value);
+      } else {
+        cache.put(key, key);
+      }
+    }
+  });
+  std::printf("  %-26s hit rate %5.1f%%  %7.2f M accesses/s\n", name,
+              100.0 * hits / keys.size(), keys.size() / ms / 1000);
+}
+
+}  // namespace
+
+int main() {
+  std::vector<uint64_t> keys = zipfian_keys();
+  std::printf("%zu Zipfian accesses (s = %.2f) over %zu keys:\n", kAccesses,
+              kSkew, kKeys);
+  for (size_t capacity : {1000, 10000, 100000}) {
+    std::printf("capacity %zu:\n", capacity);
+    {
+      LruCache<uint64_t, uint64_t> cache(capacity);
+      run("LruCache", cache, keys);
+    }
+    {
+      using Alloc =
+          StackAllocator<std::pair<uint64_t, uint64_t>, kArenaBytes>;
+      StackStorage<kArenaBytes> storage(std::pmr::new_delete_resource());
+      LruCache<uint64_t, uint64_t, Alloc> cache(capacity, Alloc(storage));
+      run("LruCache on StackStorage", cache, keys);
+    }
+    {
+      ListMapCache cache(capacity);
+      run("std::list + unordered_map", cache, keys);
+    }
+  }
+}
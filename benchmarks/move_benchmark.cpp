@@ -0,0 +1,89 @@
+// Copies made while enqueueing heavy messages into Deque and List and
+// handing the container on, by push of an lvalue, push of an rvalue and
+// emplace. Build with -O2.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "../deque.h"
+#include "../stackallocator.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kMessages = 200000;
+constexpr size_t kPayloadBytes = 512;
+
+size_t copies = 0;
+
+struct Message {
+  Message(int id, const std::string& payload) : id(id), payload(payload) {}
+  Message(const Message& other) : id(other.id), payload(other.payload) {
+    copies++;
+  }
+  Message(Message&& other) noexcept = default;
+  Message& operator=(const Message& other) {
+    id = other.id;
+    payload = other.payload;
+    copies++;
+    return *this;
+  }
+  Message& operator=(Message&& other) noexcept = default;
+
+  int id;
+  std::string payload;
+};
+
+template <typename Container, typename Push>
+void run(const char* name, Push push) {
+  const std::string payload(kPayloadBytes, 'x');
+  copies = 0;
+  double ms = time_ms([&] {
+    Container queue;
+    for (int i = 0; i < kMessages; ++i) {
+      push(queue, i, payload);
+    }
+    Container consumer = std::move(queue);
+    keep(consumer.size());
+  });
+  std::printf("  %-32s %10.2f ms %10zu copies\n", name, ms, copies);
+}
+
+template <typename Container>
+void run_all(const char* container) {
+  std::printf("%s, %d messages of %zu bytes:\n", container, kMessages,
+              kPayloadBytes);
+  run<Container>("push_back(const T&)",
+                 [](Container& queue, int id, const std::string& payload) {
+                   Message message(id, payload);
+                   queue.push_back(message);
+                 });
+  run<Container>("push_back(T&&)",
+                 [](Container& queue, int id, const std::string& payload) {
+                   Message message(id, payload);
+                   queue.push_back(std::move(message));
+                 });
+  run<Container>("emplace_back(args...)",
+                 [](Container& queue, int id, const std::string& payload) {
+                   queue.emplace_back(id, payload);
+                 });
+  copies = 0;
+  Container source;
+  for (int i = 0; i < 1000; ++i) {
+    source.emplace_back(i, std::string(kPayloadBytes, 'x'));
+  }
+  Container copied = source;
+  size_t copy_copies = copies;
+  Container moved = std::move(source);
+  std::printf("  handoff of 1000 messages: copy %zu copies, move %zu\n",
+              copy_copies, copies - copy_copies);
+}
+
+}  // namespace
+
+int main() {
+  run_all<Deque<Message>>("Deque");
+  run_all<List<Message>>("List");
+}
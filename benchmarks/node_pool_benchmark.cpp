@@ -0,0 +1,85 @@
+// List<int> on NodePoolAllocator, std::allocator and StackAllocator:
+// push/pop throughput, and traversal of 1M elements both freshly built and
+// after random churn has scattered the nodes. Build with -O2.
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <random>
+
+#include "../node_pool_allocator.h"
+#include "../stackallocator.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kElements = 1000000;
+constexpr int kRuns = 3;
+constexpr size_t kArenaBytes = 1 << 20;
+
+StackStorage<kArenaBytes> storage(std::pmr::new_delete_resource());
+
+template <typename Nodes>
+long long traverse(const Nodes& list) {
+  long long sum = 0;
+  for (int value : list) {
+    sum += value;
+  }
+  return sum;
+}
+
+template <typename Allocator>
+void run(const char* name, const Allocator& alloc) {
+  using Nodes = List<int, Allocator>;
+  std::printf("%s:\n", name);
+  report("push_back + pop_front, 1M each", best_ms(kRuns, [&] {
+           Nodes list(alloc);
+           for (int i = 0; i < kElements; ++i) {
+             list.push_back(i);
+           }
+           for (int i = 0; i < kElements; ++i) {
+             list.pop_front();
+           }
+         }));
+  report("queue of 1000, 1M pushes", best_ms(kRuns, [&] {
+           Nodes list(alloc);
+           for (int i = 0; i < kElements; ++i) {
+             list.push_back(i);
+             if (list.size() > 1000) {
+               list.pop_front();
+             }
+           }
+         }));
+
+  Nodes list(alloc);
+  for (int i = 0; i < kElements; ++i) {
+    list.push_back(i);
+  }
+  report("traverse 1M, fresh", best_ms(kRuns, [&] { keep(traverse(list)); }));
+  // Pops and pushes at random ends until most nodes have been replaced, so
+  // that list order and allocation order no longer match.
+  std::mt19937 random(1);
+  for (int i = 0; i < 4 * kElements; ++i) {
+    if (random() % 2 == 0) {
+      list.pop_back();
+    } else {
+      list.pop_front();
+    }
+    if (random() % 2 == 0) {
+      list.push_back(i);
+    } else {
+      list.push_front(i);
+    }
+  }
+  report("traverse 1M, after churn",
+         best_ms(kRuns, [&] { keep(traverse(list)); }));
+}
+
+}  // namespace
+
+int main() {
+  run("NodePoolAllocator", NodePoolAllocator<int>());
+  run("std::allocator", std::allocator<int>());
+  run("StackAllocator", StackAllocator<int, kArenaBytes>(storage));
+}
@@ -0,0 +1,86 @@
+// The segmented:: algorithms against the std:: ones on the same Deque
+// iterator range, which is a subrange so the partial first and last
+// blocks are included. Build with -O2.
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include "../deque.h"
+#include "../tests/check.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kElements = 10000000;
+constexpr int kRuns = 5;
+
+template <typename Standard, typename Segmented>
+void compare(const char* name, Standard standard_run,
+             Segmented segmented_run) {
+  double standard = best_ms(kRuns, standard_run);
+  double segmented = best_ms(kRuns, segmented_run);
+  std::printf("  %-12s std %8.2f ms  segmented %8.2f ms  x%.1f\n", name,
+              standard, segmented, standard / segmented);
+}
+
+}  // namespace
+
+int main() {
+  Deque<int> deque;
+  for (int i = 0; i < kElements; ++i) {
+    deque.push_back(i % 1000);
+  }
+  auto first = deque.begin() + 123;
+  auto last = deque.end() - 77;
+  const int missing = -1;
+  std::vector<int> output(last - first);
+
+  std::printf("Deque<int>, %d elements:\n", kElements);
+  long long std_sum = 0;
+  long long segmented_sum = 0;
+  compare(
+      "for_each",
+      [&] {
+        std_sum = 0;
+        std::for_each(first, last, [&](int value) { std_sum += value; });
+      },
+      [&] {
+        segmented_sum = 0;
+        segmented::for_each(first, last,
+                            [&](int value) { segmented_sum += value; });
+      });
+  CHECK(std_sum == segmented_sum);
+
+  compare(
+      "accumulate", [&] { std_sum = std::accumulate(first, last, 0LL); },
+      [&] { segmented_sum = segmented::accumulate(first, last, 0LL); });
+  CHECK(std_sum == segmented_sum);
+
+  long long std_count = 0;
+  long long segmented_count = 0;
+  compare(
+      "count", [&] { std_count = std::count(first, last, 7); },
+      [&] { segmented_count = segmented::count(first, last, 7); });
+  CHECK(std_count == segmented_count);
+
+  Deque<int>::iterator std_found;
+  Deque<int>::iterator segmented_found;
+  compare(
+      "find", [&] { std_found = std::find(first, last, missing); },
+      [&] { segmented_found = segmented::find(first, last, missing); });
+  CHECK(std_found == last and segmented_found == last);
+
+  compare(
+      "copy", [&] { std::copy(first, last, output.begin()); },
+      [&] { segmented::copy(first, last, output.begin()); });
+  CHECK(std::equal(first, last, output.begin()));
+
+  compare(
+      "fill", [&] { std::fill(first, last, 3); },
+      [&] { segmented::fill(first, last, 5); });
+  CHECK(deque[122] == 122 and deque[123] == 5);
+  CHECK(deque[kElements - 78] == 5 and deque[kElements - 77] != 5);
+  keep(output);
+}
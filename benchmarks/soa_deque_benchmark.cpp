@@ -0,0 +1,103 @@
+// Single-column sums over SoADeque spans against the same column read out
+// of Deque<Record>, for 10M four-field records. Build with -O2.
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../deque.h"
+#include "../soa_deque.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kRecords = 10000000;
+constexpr int kRuns = 5;
+
+struct Record {
+  int64_t timestamp;
+  double price;
+  double volume;
+  int64_t id;
+};
+
+}  // namespace
+
+int main() {
+  Deque<Record> rows;
+  SoADeque<int64_t, double, double, int64_t> columns;
+  for (int i = 0; i < kRecords; ++i) {
+    rows.push_back(Record{i, i * 0.25, 1.0, i % 97});
+    columns.push_back(i, i * 0.25, 1.0, i % 97);
+  }
+  std::printf("Sum of one column over %d records of %zu bytes:\n", kRecords,
+              sizeof(Record));
+
+  double row_sum = 0;
+  report("Deque<Record>, range for", best_ms(kRuns, [&] {
+           double sum = 0;
+           for (const Record& record : rows) {
+             sum += record.price;
+           }
+           keep(sum);
+           row_sum = sum;
+         }));
+  report("Deque<Record>, segmented::for_each", best_ms(kRuns, [&] {
+           double sum = 0;
+           segmented::for_each(rows.begin(), rows.end(),
+                                [&sum](const Record& record) {
+                                  sum += record.price;
+                                });
+           keep(sum);
+           row_sum = sum;
+         }));
+  double column_sum = 0;
+  report("SoADeque, for_each_span<1>", best_ms(kRuns, [&] {
+           double sum = 0;
+           columns.for_each_span<1>([&sum](const double* first,
+                                            const double* last) {
+             for (; first != last; ++first) {
+               sum += *first;
+             }
+           });
+           keep(sum);
+           column_sum = sum;
+         }));
+  report("SoADeque, get<1>(i)", best_ms(kRuns, [&] {
+           double sum = 0;
+           for (size_t i = 0; i < columns.size(); ++i) {
+             sum += columns.get<1>(i);
+           }
+           keep(sum);
+         }));
+  if (row_sum != column_sum) {
+    std::printf("column sums differ: %f and %f\n", row_sum, column_sum);
+    return 1;
+  }
+
+  int64_t row_ids = 0;
+  int64_t column_ids = 0;
+  report("Deque<Record>, integer column", best_ms(kRuns, [&] {
+           int64_t sum = 0;
+           segmented::for_each(rows.begin(), rows.end(),
+                                [&sum](const Record& record) {
+                                  sum += record.id;
+                                });
+           keep(sum);
+           row_ids = sum;
+         }));
+  report("SoADeque, integer column", best_ms(kRuns, [&] {
+           int64_t sum = 0;
+           columns.for_each_span<3>([&sum](const int64_t* first,
+                                           const int64_t* last) {
+             for (; first != last; ++first) {
+               sum += *first;
+             }
+           });
+           keep(sum);
+           column_ids = sum;
+         }));
+  if (row_ids != column_ids) {
+    std::printf("integer column sums differ\n");
+    return 1;
+  }
+}
@@ -0,0 +1,102 @@
+// Two-thread throughput and ping-pong round-trip latency of SpscDeque
+// against a Deque behind a mutex. Build with -O2 -pthread.
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "../deque.h"
+#include "../spsc_deque.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr long long kElements = 10000000;
+constexpr int kRoundTrips = 100000;
+
+template <typename T>
+class LockedDeque {
+ public:
+  void push_back(T value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deque_.push_back(std::move(value));
+  }
+  bool try_pop_front(T& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (deque_.size() == 0) {
+      return false;
+    }
+    value = std::move(deque_[0]);
+    deque_.pop_front();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  Deque<T> deque_;
+};
+
+template <typename Queue, typename T>
+void pop(Queue& queue, T& value) {
+  while (!queue.try_pop_front(value)) {
+    std::this_thread::yield();
+  }
+}
+
+template <typename Queue>
+void throughput(const char* name) {
+  Queue queue;
+  long long sum = 0;
+  double ms = time_ms([&] {
+    std::thread producer([&queue] {
+      for (long long i = 0; i < kElements; ++i) {
+        queue.push_back(i);
+      }
+    });
+    long long value;
+    for (long long i = 0; i < kElements; ++i) {
+      pop(queue, value);
+      sum += value;
+    }
+    producer.join();
+  });
+  keep(sum);
+  std::printf("  %-24s %8.2f ms %8.1f M elements/s\n", name, ms,
+              kElements / ms / 1000);
+}
+
+template <typename Queue>
+void latency(const char* name) {
+  Queue ping;
+  Queue pong;
+  double ms = time_ms([&] {
+    std::thread echo([&] {
+      long long value;
+      for (int i = 0; i < kRoundTrips; ++i) {
+        pop(ping, value);
+        pong.push_back(value);
+      }
+    });
+    long long value;
+    for (int i = 0; i < kRoundTrips; ++i) {
+      ping.push_back(i);
+      pop(pong, value);
+    }
+    echo.join();
+  });
+  std::printf("  %-24s %8.2f us per round trip\n", name,
+              ms * 1000 / kRoundTrips);
+}
+
+}  // namespace
+
+int main() {
+  std::printf("Throughput, %lld elements from one thread to another:\n",
+              kElements);
+  throughput<SpscDeque<long long>>("SpscDeque");
+  throughput<LockedDeque<long long>>("Deque + std::mutex");
+  std::printf("Latency, %d ping-pong round trips:\n", kRoundTrips);
+  latency<SpscDeque<long long>>("SpscDeque");
+  latency<LockedDeque<long long>>("Deque + std::mutex");
+}
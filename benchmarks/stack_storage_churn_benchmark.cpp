@@ -0,0 +1,53 @@
+// A List used as a queue of 1000 elements, churned for 10M pushes and pops
+// on a 64 KB StackStorage and on std::allocator: time, the arena's top
+// after every quarter, and global operator new calls. Build with -O2.
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+
+#include "../stackallocator.h"
+#include "benchmark.h"
+#include "counting_new.h"
+
+namespace {
+
+constexpr size_t kArenaBytes = 64 * 1024;
+constexpr int kOperations = 10000000;
+constexpr size_t kQueueLength = 1000;
+
+using Alloc = StackAllocator<int, kArenaBytes>;
+
+template <typename Queue>
+void churn(Queue& queue, int operations) {
+  for (int i = 0; i < operations; ++i) {
+    queue.push_back(i);
+    if (queue.size() > kQueueLength) {
+      queue.pop_front();
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  std::printf("List queue of %zu ints, %d pushes:\n", kQueueLength,
+              kOperations);
+  StackStorage<kArenaBytes> storage;
+  List<int, Alloc> arena_queue{Alloc(storage)};
+  size_t before = heap_allocations.load();
+  for (int step = 1; step <= 4; ++step) {
+    double ms = time_ms([&] { churn(arena_queue, kOperations / 4); });
+    std::printf(
+        "  StackStorage<64 KB>, %8d pushes %8.2f ms  arena top %6zu B  "
+        "heap calls %zu\n",
+        step * kOperations / 4, ms, storage.last_used_.load(),
+        heap_allocations.load() - before);
+  }
+
+  List<int> heap_queue;
+  before = heap_allocations.load();
+  double ms = time_ms([&] { churn(heap_queue, kOperations); });
+  std::printf("  std::allocator,       %8d pushes %8.2f ms  heap calls %zu\n",
+              kOperations, ms, heap_allocations.load() - before);
+}
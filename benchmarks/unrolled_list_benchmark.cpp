@@ -0,0 +1,78 @@
+// UnrolledList against List at 1M elements: push_back, push_front,
+// traversal, inserting in the middle of a scan, and erasing every other
+// element while iterating. Build with -O2.
+
+#include <cstdio>
+#include <iterator>
+
+#include "../stackallocator.h"
+#include "../unrolled_list.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kElements = 1000000;
+constexpr int kRuns = 3;
+
+template <typename Container>
+void run(const char* name) {
+  std::printf("%s:\n", name);
+  report("push_back 1M", best_ms(kRuns, [] {
+           Container list;
+           for (int i = 0; i < kElements; ++i) {
+             list.push_back(i);
+           }
+           keep(list.size());
+         }));
+  report("push_front 1M", best_ms(kRuns, [] {
+           Container list;
+           for (int i = 0; i < kElements; ++i) {
+             list.push_front(i);
+           }
+           keep(list.size());
+         }));
+  Container list;
+  for (int i = 0; i < kElements; ++i) {
+    list.push_back(i);
+  }
+  report("traverse 1M", best_ms(kRuns, [&list] {
+           long long sum = 0;
+           for (int value : list) {
+             sum += value;
+           }
+           keep(sum);
+         }));
+  report("insert after every 10th of 1M", best_ms(kRuns, [] {
+           Container list;
+           for (int i = 0; i < kElements; ++i) {
+             list.push_back(i);
+           }
+           int seen = 0;
+           for (auto it = list.begin(); it != list.end(); ++it) {
+             if (++seen % 10 == 0) {
+               it = list.insert(std::next(it), -1);
+             }
+           }
+           keep(list.size());
+         }));
+  report("erase every other of 1M", best_ms(kRuns, [] {
+           Container list;
+           for (int i = 0; i < kElements; ++i) {
+             list.push_back(i);
+           }
+           for (auto it = list.begin(); it != list.end();) {
+             it = list.erase(it);
+             if (it != list.end()) {
+               ++it;
+             }
+           }
+           keep(list.size());
+         }));
+}
+
+}  // namespace
+
+int main() {
+  run<UnrolledList<int>>("UnrolledList<int>");
+  run<List<int>>("List<int>");
+}
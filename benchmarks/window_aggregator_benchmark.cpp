@@ -0,0 +1,80 @@
+// Cost per tick (push one value, evict the oldest, query) of
+// WindowAggregator against rescanning the whole window, for sum and max at
+// window sizes from 1K to 10M. Build with -O2.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+
+#include "../deque.h"
+#include "../window_aggregator.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr size_t kTicks = 2000000;
+// The rescan touches the whole window on every tick, so it runs for about
+// this many element visits instead of kTicks ticks.
+constexpr size_t kRescanVisits = 200000000;
+
+struct Max {
+  long long operator()(long long lhs, long long rhs) const {
+    return std::max(lhs, rhs);
+  }
+};
+
+template <typename Aggregator>
+double incremental_ns(size_t window, std::mt19937& random) {
+  Aggregator aggregator;
+  for (size_t i = 0; i < window; ++i) {
+    aggregator.push(random() % 1000);
+  }
+  long long total = 0;
+  double ms = time_ms([&] {
+    for (size_t tick = 0; tick < kTicks; ++tick) {
+      aggregator.push(random() % 1000);
+      aggregator.evict();
+      total += aggregator.query();
+    }
+  });
+  keep(total);
+  return ms * 1e6 / kTicks;
+}
+
+template <typename Op>
+double rescan_ns(size_t window, std::mt19937& random, Op op) {
+  Deque<long long> values;
+  for (size_t i = 0; i < window; ++i) {
+    values.push_back(random() % 1000);
+  }
+  size_t ticks = std::max<size_t>(10, kRescanVisits / window);
+  long long total = 0;
+  double ms = time_ms([&] {
+    for (size_t tick = 0; tick < ticks; ++tick) {
+      values.push_back(random() % 1000);
+      values.pop_front();
+      total += segmented::accumulate(values.begin() + 1, values.end(),
+                                     values[0], op);
+    }
+  });
+  keep(total);
+  return ms * 1e6 / ticks;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 random(5);
+  std::printf("ns per tick       %14s %14s %14s %14s\n", "sum", "sum rescan",
+              "max", "max rescan");
+  for (size_t window = 1000; window <= 10000000; window *= 10) {
+    double sum = incremental_ns<WindowAggregator<long long>>(window, random);
+    double sum_rescan = rescan_ns(window, random, std::plus<long long>());
+    double max =
+        incremental_ns<WindowAggregator<long long, WindowMax>>(window, random);
+    double max_rescan = rescan_ns(window, random, Max());
+    std::printf("window %9zu %14.1f %14.1f %14.1f %14.1f\n", window, sum,
+                sum_rescan, max, max_rescan);
+  }
+}
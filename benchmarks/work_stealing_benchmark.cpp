@@ -0,0 +1,202 @@
+// Fork-join fib and parallel quicksort on WorkStealingExecutor against a
+// pool that shares one Deque behind a mutex, from one thread up to all
+// hardware threads. Build with -O2 -pthread.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../deque.h"
+#include "../work_stealing_executor.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr int kFib = 36;
+constexpr int kFibCutoff = 18;
+constexpr int kSortElements = 10000000;
+constexpr long kSortCutoff = 4096;
+
+// Every task goes through one Deque under one mutex, as in a pool built
+// without a per-worker queue.
+class LockedExecutor {
+ public:
+  using Task = std::function<void()>;
+
+  explicit LockedExecutor(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this] { work(); });
+    }
+  }
+  ~LockedExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void submit(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+  }
+
+  bool run_one() {
+    Task task;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (tasks_.size() == 0) {
+        return false;
+      }
+      task = std::move(tasks_[tasks_.size() - 1]);
+      tasks_.pop_back();
+    }
+    task();
+    return true;
+  }
+
+ private:
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  Deque<Task> tasks_;
+  bool stop_{false};
+
+  void work() {
+    while (true) {
+      if (run_one()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (stop_ and tasks_.size() == 0) {
+        return;
+      }
+      wake_.wait(lock, [this] { return stop_ or tasks_.size() > 0; });
+    }
+  }
+};
+
+// TaskGroup for either executor.
+template <typename Executor>
+class Group {
+ public:
+  explicit Group(Executor& executor) : executor_(executor) {}
+  ~Group() { wait(); }
+
+  template <typename Function>
+  void run(Function function) {
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    executor_.submit([this, function] {
+      function();
+      outstanding_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+  void wait() {
+    while (outstanding_.load(std::memory_order_acquire) != 0) {
+      if (!executor_.run_one()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  Executor& executor_;
+  std::atomic<size_t> outstanding_{0};
+};
+
+long long serial_fib(int n) {
+  return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+template <typename Executor>
+long long fib(Executor& executor, int n) {
+  if (n < kFibCutoff) {
+    return serial_fib(n);
+  }
+  long long left = 0;
+  Group<Executor> group(executor);
+  group.run([&executor, &left, n] { left = fib(executor, n - 1); });
+  long long right = fib(executor, n - 2);
+  group.wait();
+  return left + right;
+}
+
+template <typename Executor>
+void quicksort(Executor& executor, int* first, int* last) {
+  if (last - first <= kSortCutoff) {
+    std::sort(first, last);
+    return;
+  }
+  int pivot = first[(last - first) / 2];
+  int* middle =
+      std::partition(first, last, [pivot](int value) { return value < pivot; });
+  int* upper = std::partition(middle, last,
+                              [pivot](int value) { return value == pivot; });
+  Group<Executor> group(executor);
+  group.run([&executor, first, middle] { quicksort(executor, first, middle); });
+  quicksort(executor, upper, last);
+  group.wait();
+}
+
+std::vector<int> random_values() {
+  std::mt19937 random(1);
+  std::vector<int> values(kSortElements);
+  for (int& value : values) {
+    value = static_cast<int>(random());
+  }
+  return values;
+}
+
+template <typename Executor>
+void run(const char* name, size_t threads) {
+  Executor executor(threads);
+  long long result = 0;
+  double fib_ms = time_ms([&] { result = fib(executor, kFib); });
+  if (result != serial_fib(kFib)) {
+    std::printf("wrong fib(%d)\n", kFib);
+  }
+  std::vector<int> values = random_values();
+  int* data = values.data();
+  double sort_ms =
+      time_ms([&] { quicksort(executor, data, data + values.size()); });
+  if (!std::is_sorted(values.begin(), values.end())) {
+    std::printf("quicksort left the values unsorted\n");
+  }
+  std::printf("  %-22s %2zu threads  fib %8.2f ms  quicksort %8.2f ms\n", name,
+              threads, fib_ms, sort_ms);
+}
+
+}  // namespace
+
+int main() {
+  size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("fib(%d) with a cutoff of %d, quicksort of %d ints:\n", kFib,
+              kFibCutoff, kSortElements);
+  std::vector<int> values = random_values();
+  double fib_ms = time_ms([] { keep(serial_fib(kFib)); });
+  double sort_ms = time_ms([&] { std::sort(values.begin(), values.end()); });
+  std::printf("  %-22s %2d thread   fib %8.2f ms  quicksort %8.2f ms\n",
+              "serial", 1, fib_ms, sort_ms);
+  std::vector<size_t> counts;
+  for (size_t threads = 1; threads < hardware; threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(hardware);
+  for (size_t threads : counts) {
+    run<WorkStealingExecutor>("WorkStealingExecutor", threads);
+    run<LockedExecutor>("Deque + std::mutex", threads);
+  }
+}
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Singly linked list that many threads push to and read at once.
+// push_front() CASes the sentinel's link. push_back() appends Michael-Scott
+// style: it CASes the null link of the last node and then swings tail_, and
+// a thread that finds tail_ lagging swings it first. Readers walk the list
+// forward and never wait.
+//
+// remove_if() marks nodes erased, which hides them from readers at once, and
+// unlinks them. Removals are serialized by a mutex. The last node is only
+// unlinked once something has been appended after it, so a pusher never
+// appends to an unlinked node.
+//
+// Unlinked nodes are reclaimed with epochs. Readers and pushers pin the
+// current epoch while they hold node pointers. A node retired in epoch e is
+// destroyed once the epoch reaches e + 2. The epoch only advances past e + 1
+// after every thread pinned at e has let go.
+//
+// Iterators are only valid while the thread holds a ReadGuard from pin().
+// Pushing threads call the Allocator concurrently, so it must be
+// thread-safe: std::allocator, or a StackAllocator with the ConcurrentArena
+// policy. Construction and destruction must not race with anything.
+template <typename T, typename Allocator = std::allocator<T>>
+class ConcurrentList {
+  struct Node;
+
+  struct BaseNode {
+    std::atomic<Node*> next{nullptr};
+  };
+
+  struct Node : BaseNode {
+    T value;
+    std::atomic<bool> erased{false};
+    // Link and epoch in the retired list; next stays intact for readers
+    // that are still on the node.
+    Node* retired = nullptr;
+    size_t retired_epoch = 0;
+
+    template <typename... Args>
+    Node(Args&&... args) : value(std::forward<Args>(args)...) {}
+  };
+
+  static constexpr size_t kCacheLine = 64;
+  static constexpr size_t kStripes = 16;
+
+  // Pin counts of the threads mapped to this stripe, by epoch parity.
+  struct alignas(kCacheLine) Stripe {
+    std::atomic<size_t> pinned[2]{};
+  };
+
+  using NodeAlloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using AllocTraits = std::allocator_traits<NodeAlloc>;
+
+ public:
+  class ReadGuard;
+  class const_iterator;
+
+  ConcurrentList() : ConcurrentList(Allocator()) {}
+  explicit ConcurrentList(const Allocator& alloc) : alloc_(alloc) {}
+  ConcurrentList(const ConcurrentList&) = delete;
+  ConcurrentList& operator=(const ConcurrentList&) = delete;
+  ~ConcurrentList();
+
+  // Lock-free; any thread.
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+
+  // Any thread; removals run one at a time and call `predicate` under the
+  // removal mutex. Returns the number of elements removed. Nodes removed
+  // while readers are pinned are destroyed by a later call.
+  template <typename Predicate>
+  size_t remove_if(Predicate predicate);
+  size_t remove(const T& value) {
+    return remove_if([&value](const T& element) { return element == value; });
+  }
+  void clear() {
+    remove_if([](const T&) { return true; });
+  }
+
+  // Exact only while no push or removal is in flight.
+  [[nodiscard]] size_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  // Keeps every node the calling thread can reach alive until the guard is
+  // destroyed.
+  ReadGuard pin() const { return ReadGuard(enter()); }
+
+  const_iterator begin() const {
+    return const_iterator(head_.next.load(std::memory_order_acquire));
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  template <typename Function>
+  void for_each(Function function) const {
+    ReadGuard guard = pin();
+    for (const T& value : *this) {
+      function(value);
+    }
+  }
+
+ private:
+  alignas(kCacheLine) BaseNode head_;
+  alignas(kCacheLine) std::atomic<BaseNode*> tail_{&head_};
+  alignas(kCacheLine) std::atomic<size_t> size_{0};
+  std::atomic<size_t> epoch_{0};
+  mutable Stripe stripes_[kStripes];
+  NodeAlloc alloc_;
+
+  // Owned by the thread holding removal_mutex_.
+  std::mutex removal_mutex_;
+  Node* retired_head_ = nullptr;
+  Node* retired_tail_ = nullptr;
+
+  template <typename... Args>
+  Node* create_node(Args&&... args) {
+    Node* new_node(AllocTraits::allocate(alloc_, 1));
+    try {
+      AllocTraits::construct(alloc_, new_node, std::forward<Args>(args)...);
+    } catch (...) {
+      AllocTraits::deallocate(alloc_, new_node, 1);
+      throw;
+    }
+    return new_node;
+  }
+  void destroy_node(Node* node) {
+    AllocTraits::destroy(alloc_, node);
+    AllocTraits::deallocate(alloc_, node, 1);
+  }
+
+  static Node* skip_erased(Node* node) {
+    while (node != nullptr and node->erased.load(std::memory_order_acquire)) {
+      node = node->next.load(std::memory_order_acquire);
+    }
+    return node;
+  }
+
+  static size_t this_thread_stripe() {
+    static std::atomic<size_t> threads{0};
+    thread_local size_t stripe =
+        threads.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return stripe;
+  }
+
+  std::atomic<size_t>* enter() const;
+  static bool reaches(BaseNode* from, Node* node);
+  void unlink(BaseNode*& prev, Node* node, Node* next);
+  void collect();
+};
+
+template <typename T, typename Allocator>
+class ConcurrentList<T, Allocator>::ReadGuard {
+ public:
+  ReadGuard(ReadGuard&& guard) noexcept
+      : pinned_(std::exchange(guard.pinned_, nullptr)) {}
+  ReadGuard& operator=(ReadGuard&&) = delete;
+  ~ReadGuard() {
+    if (pinned_ != nullptr) {
+      pinned_->fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+ private:
+  friend class ConcurrentList;
+
+  explicit ReadGuard(std::atomic<size_t>* pinned) : pinned_(pinned) {}
+
+  std::atomic<size_t>* pinned_;
+};
+
+template <typename T, typename Allocator>
+class ConcurrentList<T, Allocator>::const_iterator {
+ public:
+  using value_type = T;
+  using pointer = const T*;
+  using reference = const T&;
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = long long;
+
+  const_iterator() = default;
+
+  reference operator*() const { return node_->value; }
+  pointer operator->() const { return &node_->value; }
+
+  const_iterator& operator++() {
+    node_ = skip_erased(node_->next.load(std::memory_order_acquire));
+    return *this;
+  }
+  const_iterator operator++(int) {
+    auto it = *this;
+    ++*this;
+    return it;
+  }
+
+  bool operator==(const const_iterator& it) const { return node_ == it.node_; }
+  bool operator!=(const const_iterator& it) const { return !((*this) == it); }
+
+ private:
+  friend class ConcurrentList;
+
+  explicit const_iterator(Node* node) : node_(skip_erased(node)) {}
+
+  Node* node_ = nullptr;
+};
+
+template <typename T, typename Allocator>
+ConcurrentList<T, Allocator>::~ConcurrentList() {
+  Node* node = head_.next.load(std::memory_order_relaxed);
+  while (node != nullptr) {
+    Node* next = node->next.load(std::memory_order_relaxed);
+    destroy_node(node);
+    node = next;
+  }
+  while (retired_head_ != nullptr) {
+    Node* retired = retired_head_->retired;
+    destroy_node(retired_head_);
+    retired_head_ = retired;
+  }
+}
+
+// A thread that bumps the counter of a stale epoch backs out before it
+// touches a node, so a reclaimer may safely miss it.
+template <typename T, typename Allocator>
+std::atomic<size_t>* ConcurrentList<T, Allocator>::enter() const {
+  Stripe& stripe = stripes_[this_thread_stripe()];
+  while (true) {
+    size_t epoch = epoch_.load();
+    std::atomic<size_t>& pinned = stripe.pinned[epoch & 1];
+    pinned.fetch_add(1);
+    if (epoch_.load() == epoch) {
+      return &pinned;
+    }
+    pinned.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void ConcurrentList<T, Allocator>::emplace_back(Args&&... args) {
+  Node* node = create_node(std::forward<Args>(args)...);
+  ReadGuard guard = pin();
+  while (true) {
+    BaseNode* tail = tail_.load(std::memory_order_acquire);
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                  std::memory_order_relaxed);
+      continue;
+    }
+    if (tail->next.compare_exchange_weak(next, node,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+      tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                    std::memory_order_relaxed);
+      break;
+    }
+  }
+  size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Never dereferences a node, so it needs no pin.
+template <typename T, typename Allocator>
+template <typename... Args>
+void ConcurrentList<T, Allocator>::emplace_front(Args&&... args) {
+  Node* node = create_node(std::forward<Args>(args)...);
+  Node* first = head_.next.load(std::memory_order_relaxed);
+  do {
+    node->next.store(first, std::memory_order_relaxed);
+  } while (!head_.next.compare_exchange_weak(first, node,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+  if (first == nullptr) {
+    BaseNode* sentinel = &head_;
+    tail_.compare_exchange_strong(sentinel, node, std::memory_order_release,
+                                  std::memory_order_relaxed);
+  }
+  size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T, typename Allocator>
+template <typename Predicate>
+size_t ConcurrentList<T, Allocator>::remove_if(Predicate predicate) {
+  std::lock_guard<std::mutex> lock(removal_mutex_);
+  size_t count = 0;
+  BaseNode* prev = &head_;
+  Node* node = head_.next.load(std::memory_order_acquire);
+  while (node != nullptr) {
+    if (!node->erased.load(std::memory_order_relaxed)) {
+      if (!predicate(node->value)) {
+        prev = node;
+        node = node->next.load(std::memory_order_acquire);
+        continue;
+      }
+      node->erased.store(true, std::memory_order_release);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      count++;
+    }
+    Node* next = node->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      // Pushers may be appending to it; a later call unlinks it.
+      break;
+    }
+    unlink(prev, node, next);
+    node = next;
+  }
+  collect();
+  return count;
+}
+
+// Whether `node` is `from` or lies beyond it.
+template <typename T, typename Allocator>
+bool ConcurrentList<T, Allocator>::reaches(BaseNode* from, Node* node) {
+  for (; from != nullptr; from = from->next.load()) {
+    if (from == node) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T, typename Allocator>
+void ConcurrentList<T, Allocator>::unlink(BaseNode*& prev, Node* node,
+                                          Node* next) {
+  // tail_ only moves forward. Once it is past `node`, no pusher can swing
+  // it onto the node, so tail_ never points at a reclaimed node. The check
+  // and the swing use the same snapshot of tail_: a pusher may move tail_
+  // to the last node in between, and that node has no successor to swing
+  // to.
+  while (true) {
+    BaseNode* tail = tail_.load();
+    if (!reaches(tail, node)) {
+      break;
+    }
+    if (Node* successor = tail->next.load()) {
+      tail_.compare_exchange_strong(tail, successor);
+    }
+  }
+  Node* expected = node;
+  while (!prev->next.compare_exchange_strong(expected, next)) {
+    // Only push_front() changes a link in front of the last node, so the
+    // node now sits behind new nodes at the front.
+    prev = &head_;
+    while (prev->next.load() != node) {
+      prev = prev->next.load();
+    }
+    expected = node;
+  }
+  node->retired_epoch = epoch_.load();
+  if (retired_tail_ == nullptr) {
+    retired_head_ = node;
+  } else {
+    retired_tail_->retired = node;
+  }
+  retired_tail_ = node;
+}
+
+// Advances the epoch if nobody is pinned at the previous one, then destroys
+// the nodes retired at least two epochs ago.
+template <typename T, typename Allocator>
+void ConcurrentList<T, Allocator>::collect() {
+  size_t epoch = epoch_.load(std::memory_order_relaxed);
+  size_t pinned = 0;
+  for (Stripe& stripe : stripes_) {
+    pinned += stripe.pinned[(epoch + 1) & 1].load();
+  }
+  if (pinned == 0) {
+    epoch_.store(++epoch);
+  }
+  while (retired_head_ != nullptr and
+         retired_head_->retired_epoch + 2 <= epoch) {
+    Node* retired = retired_head_->retired;
+    destroy_node(retired_head_);
+    retired_head_ = retired;
+  }
+  if (retired_head_ == nullptr) {
+    retired_tail_ = nullptr;
+  }
+}
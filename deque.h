@@ -1,28 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
-#include <vector>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <new>
+#include <type_traits>
+
+// Compile-time choice of the Deque block geometry: a block holds
+// BlockBytes / sizeof(T) elements (never fewer than MinElements) and its
+// memory is aligned to Alignment bytes, rounded up to whole alignment units
+// so that neighbouring blocks never share a cache line.
+template <size_t BlockBytes = 4096, size_t Alignment = 64,
+          size_t MinElements = 16>
+struct DequeBlockPolicy {
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "block alignment must be a power of two");
+
+  template <typename T>
+  static constexpr size_t kElements =
+      std::max<size_t>(BlockBytes / sizeof(T),
+                       MinElements > 0 ? MinElements : 1);
+
+  template <typename T>
+  static constexpr size_t kAlignment = std::max(Alignment, alignof(T));
+};
+
+using CacheLineBlocks = DequeBlockPolicy<64, 64, 1>;
+using PageBlocks = DequeBlockPolicy<4096, 4096, 1>;
 
-template <typename T>
+template <typename T, typename Allocator = std::allocator<T>,
+          typename BlockPolicy = DequeBlockPolicy<>>
 class Deque {
  public:
+  using AllocTraits = std::allocator_traits<Allocator>;
+
+  static_assert(std::is_same_v<typename AllocTraits::value_type, T>,
+                "Deque must have the same value_type as its allocator");
+
   Deque();
-  Deque(const Deque<T>& deque);
-  Deque(int size);
-  Deque(int size, const T& value);
-  Deque<T>& operator=(const Deque<T>& deque);
+  Deque(const Allocator& alloc);
+  Deque(const Deque& deque);
+  Deque(const Deque& deque, const Allocator& alloc);
+  Deque(Deque&& deque) noexcept;
+  Deque(int size, const Allocator& alloc = Allocator());
+  Deque(int size, const T& value, const Allocator& alloc = Allocator());
+  Deque& operator=(const Deque& deque);
+  Deque& operator=(Deque&& deque) noexcept(
+      AllocTraits::propagate_on_container_move_assignment::value ||
+      AllocTraits::is_always_equal::value);
   ~Deque();
 
+  void swap(Deque& deque) noexcept;
+
   [[nodiscard]] size_t size() const;
 
+  Allocator get_allocator() const { return alloc_; }
+
   T& operator[](size_t index);
   const T& operator[](size_t index) const;
   T& at(ssize_t index);
   const T& at(ssize_t index) const;
 
   void push_back(const T& value);
+  void push_back(T&& value);
   void pop_back();
   void push_front(const T& value);
+  void push_front(T&& value);
   void pop_front();
 
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  template <typename... Args>
+  T& emplace_front(Args&&... args);
+
+  template <typename InputIt>
+  void append_range(InputIt first, InputIt last);
+  template <typename Range>
+  void append_range(Range&& range);
+  template <typename InputIt>
+  void prepend_range(InputIt first, InputIt last);
+  template <typename Range>
+  void prepend_range(Range&& range);
+
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void assign(InputIt first, InputIt last);
+  void assign(size_t count, const T& value);
+  void resize(size_t count);
+  void resize(size_t count, const T& value);
+  void clear();
+
+  // Make room for `count` more elements at the corresponding end, so that
+  // pushing them does not touch the allocator.
+  void reserve_back(size_t count);
+  void reserve_front(size_t count);
+
+  // Number of elements that can be pushed at the corresponding end without
+  // touching the allocator; reserve_back(n) makes capacity_back() >= n.
+  // Spare blocks are shared by both ends, so the two figures overlap.
+  [[nodiscard]] size_t capacity_back() const;
+  [[nodiscard]] size_t capacity_front() const;
+  // Bytes currently held from the allocator: used and spare blocks plus
+  // the block map.
+  [[nodiscard]] size_t allocated_bytes() const;
+
+  // Frees every spare block and shrinks the map to the used blocks.
+  void shrink_to_fit();
+  // Frees spare blocks until at most `max_spare_blocks` are left.
+  void trim(size_t max_spare_blocks);
+  // While enabled, a pop that drains a block halves the spare list
+  // whenever fewer than `min_occupancy` of the held element slots are in
+  // use. 0 (the default) disables it.
+  void set_auto_trim(double min_occupancy);
+
   template <bool IsConst>
   class common_iterator;
 
@@ -31,26 +124,15 @@ class Deque {
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-  iterator begin() { return iterator(&deque_[start_ / kBase], start_ % kBase); }
-  const_iterator begin() const {
-    return const_iterator(&deque_[start_ / kBase], start_ % kBase);
-  }
-  iterator end() {
-    return iterator(&deque_[last_used_block(size_ + 1)],
-                    last_in_block(last_used_block(size_ + 1), size_ + 1));
-  }
+  iterator begin() { return iterator_at<iterator>(start_); }
+  const_iterator begin() const { return iterator_at<const_iterator>(start_); }
+  iterator end() { return iterator_at<iterator>(start_ + size_); }
   const_iterator end() const {
-    return const_iterator(&deque_[last_used_block(size_ + 1)],
-                          last_in_block(last_used_block(size_ + 1), size_ + 1));
+    return iterator_at<const_iterator>(start_ + size_);
   }
 
-  const_iterator cbegin() const {
-    return const_iterator(&deque_[start_ / kBase], start_ % kBase);
-  }
-  const_iterator cend() const {
-    return const_iterator(&deque_[last_used_block(size_ + 1)],
-                          last_in_block(last_used_block(size_ + 1), size_ + 1));
-  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
 
   reverse_iterator rbegin() { return std::make_reverse_iterator(end()); }
   const_reverse_iterator rbegin() const {
@@ -68,241 +150,767 @@ class Deque {
     return std::make_reverse_iterator(cbegin());
   }
 
+  // Insertion and erasure in the middle shift whichever side of the
+  // position is shorter, so they cost O(min(pos, size() - pos)).
   void insert(iterator iter, const T& element);
+  void insert(iterator iter, T&& element);
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  iterator insert(iterator iter, InputIt first, InputIt last);
+  template <typename... Args>
+  iterator emplace(iterator iter, Args&&... args);
   void erase(iterator iter);
+  iterator erase(iterator first, iterator last);
 
  private:
-  std::vector<T*> deque_;
+  // Block map: slots outside the used range are always nullptr. Blocks
+  // drained by pops are kept in an intrusive spare list and handed out
+  // again before any new block is requested from the heap. The map itself
+  // is only allocated by the first insertion, so an empty deque owns no
+  // memory.
+  struct SpareBlock {
+    SpareBlock* next;
+  };
+
+  struct alignas(BlockPolicy::template kAlignment<T>) BlockChunk {
+    unsigned char bytes[BlockPolicy::template kAlignment<T>];
+  };
+
+  using MapAlloc = typename AllocTraits::template rebind_alloc<T*>;
+  using MapTraits = std::allocator_traits<MapAlloc>;
+  using BlockAlloc = typename AllocTraits::template rebind_alloc<BlockChunk>;
+  using BlockTraits = std::allocator_traits<BlockAlloc>;
+
+  T** map_{nullptr};
+  size_t map_size_{0};
   size_t size_{0};
-  size_t allocated_blocks_{0};
   size_t start_{0};
-  static const int kBase = 32;
+  SpareBlock* spare_blocks_{nullptr};
+  size_t spare_count_{0};
+  double min_occupancy_{0};
+  static constexpr int kBase =
+      static_cast<int>(BlockPolicy::template kElements<T>);
+  static constexpr size_t kBlockAlignment = alignof(BlockChunk);
+  static constexpr size_t kBlockChunks =
+      (std::max(kBase * sizeof(T), sizeof(SpareBlock)) + kBlockAlignment - 1) /
+      kBlockAlignment;
+  static constexpr size_t kBlockBytes = kBlockChunks * sizeof(BlockChunk);
+
+  Allocator alloc_;
 
-  size_t first_in_block(size_t index) const {
-    return (index == block(start_) ? start_ % kBase : 0);
+  size_t block(size_t index) const { return index / kBase; }
+  size_t first_used_block() const { return block(start_); }
+  size_t end_used_block() const {
+    return (size_ == 0 ? block(start_) : block(start_ + size_ - 1) + 1);
+  }
+
+  T* allocate_block() {
+    BlockAlloc block_alloc(alloc_);
+    return reinterpret_cast<T*>(
+        BlockTraits::allocate(block_alloc, kBlockChunks));
+  }
+  void deallocate_block(void* block_ptr) {
+    BlockAlloc block_alloc(alloc_);
+    BlockTraits::deallocate(block_alloc, static_cast<BlockChunk*>(block_ptr),
+                            kBlockChunks);
   }
-  size_t last_in_block(size_t index, size_t size) const {
-    if (size == 0) {
-      return 0;
+
+  T** allocate_map(size_t map_size) {
+    MapAlloc map_alloc(alloc_);
+    T** map = MapTraits::allocate(map_alloc, map_size);
+    std::fill(map, map + map_size, nullptr);
+    return map;
+  }
+  void deallocate_map() {
+    if (map_ != nullptr) {
+      MapAlloc map_alloc(alloc_);
+      MapTraits::deallocate(map_alloc, map_, map_size_);
     }
-    return (index == last_used_block(size) ? (start_ + size - 1) % kBase
-                                           : kBase - 1);
+    map_ = nullptr;
+    map_size_ = 0;
   }
-  size_t block(size_t index) const { return index / kBase; }
-  size_t last_used_block(size_t size) const {
-    if (size == 0) {
-      return 0;
+  // Moves the map into a freshly allocated one of `map_size` slots, with
+  // every block pointer shifted `offset` slots towards the back.
+  void reallocate_map(size_t map_size, size_t offset) {
+    T** map = allocate_map(map_size);
+    if (map_ != nullptr) {
+      std::copy(map_, map_ + map_size_, map + offset);
     }
-    return (start_ + size - 1) / kBase;
+    deallocate_map();
+    map_ = map;
+    map_size_ = map_size;
+    start_ += offset * kBase;
   }
 
-  void memory_allocation() {
-    size_t number_of_used_blocks = (size_ + kBase - 1) / kBase;
-    if (size_ == 0) {
-      number_of_used_blocks = 1;
+  T* acquire_block() {
+    if (spare_blocks_ == nullptr) {
+      return allocate_block();
     }
-    std::vector<T*> temporary(number_of_used_blocks * 3);
-    for (size_t i = 0; i < number_of_used_blocks; i++) {
-      temporary[i] = (reinterpret_cast<T*>(new char[kBase * sizeof(T)]));
-      temporary[i + number_of_used_blocks] = deque_[block(start_) + i];
+    SpareBlock* spare = spare_blocks_;
+    spare_blocks_ = spare->next;
+    spare_count_--;
+    return reinterpret_cast<T*>(spare);
+  }
+  void release_block(T*& block_ptr) {
+    spare_blocks_ = new (block_ptr) SpareBlock{spare_blocks_};
+    spare_count_++;
+    block_ptr = nullptr;
+  }
+  void free_spare_blocks(size_t keep = 0) {
+    while (spare_count_ > keep) {
+      SpareBlock* next = spare_blocks_->next;
+      deallocate_block(spare_blocks_);
+      spare_blocks_ = next;
+      spare_count_--;
+    }
+  }
+  // Called after a pop has released a block.
+  void auto_trim() {
+    if (min_occupancy_ == 0) {
+      return;
+    }
+    size_t held = end_used_block() - first_used_block() + spare_count_;
+    if (size_ < min_occupancy_ * held * kBase) {
+      free_spare_blocks(spare_count_ / 2);
     }
-    for (size_t i = number_of_used_blocks * 2; i < (number_of_used_blocks * 3);
-         i++) {
-      temporary[i] = (reinterpret_cast<T*>(new char[kBase * sizeof(T)]));
+  }
+
+  // Moves the used part of the map by `offset` slots; the slots it leaves
+  // are reset to nullptr.
+  void shift_blocks(long long offset) {
+    size_t first = first_used_block();
+    size_t last = end_used_block();
+    T** map = map_;
+    if (offset < 0) {
+      size_t shift = -offset;
+      std::copy(map + first, map + last, map + (first - shift));
+      std::fill(map + std::max(first, last - shift), map + last, nullptr);
+      start_ -= shift * kBase;
+    } else {
+      size_t shift = offset;
+      std::copy_backward(map + first, map + last, map + (last + shift));
+      std::fill(map + first, map + std::min(last, first + shift), nullptr);
+      start_ += shift * kBase;
     }
+  }
+
+  // The map always keeps one free slot after the used range, so the slot
+  // of end() can be read even when the last block is full.
 
-    for (size_t i = 0; i < block(start_); i++) {
-      delete[] reinterpret_cast<char*>(deque_[i]);
+  // Guarantees `blocks` free map slots after the used range (plus the end()
+  // slot). The map is recentered when at least half of it is free at the
+  // front, otherwise it doubles towards the back.
+  void make_back_room(size_t blocks) {
+    size_t map_size = map_size_;
+    size_t front = first_used_block();
+    size_t back = map_size - end_used_block();
+    if (back >= blocks + 1) {
+      return;
     }
-    for (size_t i = last_used_block(size_) + 1; i < allocated_blocks_; i++) {
-      delete[] reinterpret_cast<char*>(deque_[i]);
+    if (front >= map_size / 2 and front + back >= blocks + 1) {
+      long long shift = front - (front + back - blocks - 1) / 2;
+      shift_blocks(-shift);
+      return;
     }
+    reallocate_map(std::max(map_size * 2, end_used_block() + blocks + 1), 0);
+  }
 
-    deque_.swap(temporary);
-    allocated_blocks_ = number_of_used_blocks * 3;
-    start_ = number_of_used_blocks * kBase;
+  // Mirror image of make_back_room for the front of the map.
+  void make_front_room(size_t blocks) {
+    size_t map_size = map_size_;
+    size_t front = first_used_block();
+    size_t back = map_size - end_used_block();
+    if (front >= blocks) {
+      return;
+    }
+    if (back > map_size / 2 and front + back >= blocks + 1) {
+      shift_blocks(back - 1 - (front + back - blocks - 1) / 2);
+      return;
+    }
+    size_t added = std::max(map_size, blocks - front);
+    reallocate_map(map_size + added + (back == 0 ? 1 : 0), added);
   }
 
-  void zero_allocation() {
-    deque_.push_back(reinterpret_cast<T*>(new char[kBase * sizeof(T)]));
-    allocated_blocks_ = 1;
+  template <typename Iterator>
+  Iterator iterator_at(size_t index) const {
+    if (map_ == nullptr) {
+      return Iterator();
+    }
+    return Iterator(map_ + block(index), map_[block(index)] + index % kBase);
   }
-};
-template <typename T>
-Deque<T>::Deque() {
-  zero_allocation();
-}
 
-template <typename T>
-Deque<T>::Deque(const Deque<T>& deque)
-    : deque_(std::vector<T*>(deque.allocated_blocks_)),
-      size_(deque.size_),
-      allocated_blocks_(deque.allocated_blocks_),
-      start_(deque.start_) {
-  try {
-    for (size_t i = 0; i < allocated_blocks_; i++) {
-      deque_[i] = reinterpret_cast<T*>(new char[kBase * sizeof(T)]);
-      for (size_t j = first_in_block(i); j <= last_in_block(i, size_); j++) {
-        new (deque_[i] + j) T(deque.deque_[i][j]);
+  template <typename Alloc, typename = void>
+  struct HasConstruct : std::false_type {};
+  template <typename Alloc>
+  struct HasConstruct<Alloc,
+                      std::void_t<decltype(std::declval<Alloc&>().construct(
+                          std::declval<T*>(), std::declval<const T&>()))>>
+      : std::true_type {};
+
+  // True when AllocTraits::construct is plain placement new, so whole block
+  // segments can be filled with the std::uninitialized_* algorithms (memcpy
+  // or memset for trivial T).
+  static constexpr bool kPlainConstruct =
+      std::is_same_v<Allocator, std::allocator<T>> ||
+      !HasConstruct<Allocator>::value;
+
+  void reserve_spare_blocks(size_t count) {
+    while (spare_count_ < count) {
+      T* block_ptr = allocate_block();
+      release_block(block_ptr);
+    }
+  }
+  void fill_map(size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+      if (map_[i] == nullptr) {
+        map_[i] = acquire_block();
       }
     }
-  } catch (...) {
-    throw;
   }
-}
-template <typename T>
-Deque<T>::Deque(int size)
-    : deque_(std::vector<T*>((size + kBase - 1) / kBase)),
-      size_(size),
-      allocated_blocks_((size + kBase - 1) / kBase),
-      start_(0) {
-  for (size_t i = 0; i < allocated_blocks_; i++) {
-    deque_[i] = reinterpret_cast<T*>(new char[kBase * sizeof(T)]);
-    for (size_t j = 0; j <= last_in_block(i, size_); j++) {
-      try {
-        new (deque_[i] + j) T();
-      } catch (...) {
-        for (size_t k = 0; k < i; ++k) {
-          for (size_t len = 0; len < kBase; len++) {
-            (deque_[k] + len)->~T();
-          }
-        }
-        for (size_t len = 0; len < j; len++) {
-          (deque_[i] + len)->~T();
-        }
-        for (size_t k = 0; k <= i; ++k) {
-          delete[] reinterpret_cast<char*>(deque_[k]);
-        }
-        throw;
+  void drain_map(size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+      if (map_[i] != nullptr) {
+        release_block(map_[i]);
       }
     }
   }
-}
-template <typename T>
-Deque<T>::Deque(int size, const T& value)
-    : deque_(std::vector<T*>((size + kBase - 1) / kBase)),
-      size_(size),
-      allocated_blocks_((size + kBase - 1) / kBase),
-      start_(0) {
-  for (size_t i = 0; i < allocated_blocks_; i++) {
-    deque_[i] = reinterpret_cast<T*>(new char[kBase * sizeof(T)]);
-    for (size_t j = 0; j <= last_in_block(i, size_); j++) {
-      try {
-        new (deque_[i] + j) T(value);
-      } catch (...) {
-        for (size_t k = 0; k < i; k++) {
-          for (size_t len = 0; len < kBase; len++) {
-            (deque_[k] + len)->~T();
-          }
-        }
-        for (size_t len = 0; len < j; len++) {
-          (deque_[i] + len)->~T();
-        }
-        for (size_t k = 0; k <= i; ++k) {
-          delete[] reinterpret_cast<char*>(deque_[k]);
-        }
-        throw;
+
+  // Constructs `count` elements into the free slots starting at global
+  // index `from`, whose blocks are already in the map. `construct(place, n)`
+  // builds n elements at place (or none, if it throws), so it is called once
+  // per contiguous block segment. On failure everything built here is
+  // destroyed again.
+  template <typename Construct>
+  void construct_segments(size_t from, size_t count, Construct construct) {
+    size_t done = 0;
+    try {
+      while (done < count) {
+        size_t index = from + done;
+        size_t chunk = std::min<size_t>(count - done, kBase - index % kBase);
+        construct(map_[block(index)] + index % kBase, chunk);
+        done += chunk;
       }
+    } catch (...) {
+      destroy_range(from, done);
+      throw;
     }
   }
+
+  void destroy_range(size_t from, size_t count) {
+    for (size_t i = from; i < from + count; i++) {
+      AllocTraits::destroy(alloc_, map_[block(i)] + i % kBase);
+    }
+  }
+
+  template <typename Make>
+  void construct_each(T* place, size_t count, Make make) {
+    size_t i = 0;
+    try {
+      for (; i < count; i++) {
+        make(place + i);
+      }
+    } catch (...) {
+      while (i > 0) {
+        AllocTraits::destroy(alloc_, place + --i);
+      }
+      throw;
+    }
+  }
+
+  // Appends or prepends `count` elements built by `construct` (see
+  // construct_segments). Either all of them are added or none.
+  template <typename Construct>
+  void construct_back(size_t count, Construct construct) {
+    if (count == 0) {
+      return;
+    }
+    reserve_back(count);
+    size_t from = start_ + size_;
+    size_t first_fresh = block(from + kBase - 1);
+    size_t last_fresh = block(from + count - 1) + 1;
+    fill_map(first_fresh, last_fresh);
+    try {
+      construct_segments(from, count, construct);
+    } catch (...) {
+      drain_map(first_fresh, last_fresh);
+      throw;
+    }
+    size_ += count;
+  }
+  template <typename Construct>
+  void construct_front(size_t count, Construct construct) {
+    if (count == 0) {
+      return;
+    }
+    reserve_front(count);
+    size_t from = start_ - count;
+    fill_map(block(from), block(start_));
+    try {
+      construct_segments(from, count, construct);
+    } catch (...) {
+      drain_map(block(from), block(start_));
+      throw;
+    }
+    start_ = from;
+    size_ += count;
+  }
+
+  template <typename ForwardIt>
+  auto copy_construct(ForwardIt& first) {
+    return [this, &first](T* place, size_t count) {
+      ForwardIt last = std::next(first, count);
+      if constexpr (kPlainConstruct) {
+        std::uninitialized_copy(first, last, place);
+      } else {
+        ForwardIt current = first;
+        construct_each(place, count, [this, &current](T* element) {
+          AllocTraits::construct(alloc_, element, *current);
+          ++current;
+        });
+      }
+      first = last;
+    };
+  }
+
+  auto fill_construct(const T& value) {
+    return [this, &value](T* place, size_t count) {
+      if constexpr (kPlainConstruct) {
+        std::uninitialized_fill_n(place, count, value);
+      } else {
+        construct_each(place, count, [this, &value](T* element) {
+          AllocTraits::construct(alloc_, element, value);
+        });
+      }
+    };
+  }
+
+  auto value_construct() {
+    return [this](T* place, size_t count) {
+      if constexpr (kPlainConstruct) {
+        std::uninitialized_value_construct_n(place, count);
+      } else {
+        construct_each(place, count, [this](T* element) {
+          AllocTraits::construct(alloc_, element);
+        });
+      }
+    };
+  }
+
+  template <typename ForwardIt>
+  iterator insert_range(size_t index, ForwardIt first, size_t count);
+
+  // std::move and std::move_backward over Deque ranges, one contiguous
+  // piece of source and destination block at a time.
+  static iterator move_forward(iterator first, iterator last, iterator dest);
+  static iterator move_backward(iterator first, iterator last,
+                                iterator dest_last);
+
+  void clear_memory() {
+    for (size_t i = 0; i < size_; i++) {
+      AllocTraits::destroy(alloc_, &operator[](i));
+    }
+    for (size_t i = first_used_block(); i < end_used_block(); i++) {
+      deallocate_block(map_[i]);
+    }
+    free_spare_blocks();
+    deallocate_map();
+  }
+
+  void swap_contents(Deque& deque) noexcept {
+    std::swap(deque.map_, map_);
+    std::swap(deque.map_size_, map_size_);
+    std::swap(deque.size_, size_);
+    std::swap(deque.start_, start_);
+    std::swap(deque.spare_blocks_, spare_blocks_);
+    std::swap(deque.spare_count_, spare_count_);
+    std::swap(deque.min_occupancy_, min_occupancy_);
+  }
+
+  void swap_deques(Deque& deque) noexcept {
+    swap_contents(deque);
+    std::swap(deque.alloc_, alloc_);
+  }
+};
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque() {}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(const Allocator& alloc)
+    : alloc_(alloc) {}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(const Deque& deque)
+    : Deque(deque,
+            AllocTraits::select_on_container_copy_construction(deque.alloc_)) {}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(const Deque& deque,
+                                        const Allocator& alloc)
+    : alloc_(alloc) {
+  try {
+    append_range(deque.begin(), deque.end());
+  } catch (...) {
+    clear_memory();
+    throw;
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(Deque&& deque) noexcept
+    : alloc_(std::move(deque.alloc_)) {
+  swap_contents(deque);
 }
-template <typename T>
-Deque<T>& Deque<T>::operator=(const Deque<T>& deque) {
-  Deque temporary(deque);
-  std::swap(temporary.deque_, deque_);
-  std::swap(temporary.size_, size_);
-  std::swap(temporary.allocated_blocks_, allocated_blocks_);
-  std::swap(temporary.start_, start_);
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(int size, const Allocator& alloc)
+    : alloc_(alloc) {
+  try {
+    resize(size);
+  } catch (...) {
+    clear_memory();
+    throw;
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::Deque(int size, const T& value,
+                                        const Allocator& alloc)
+    : alloc_(alloc) {
+  try {
+    resize(size, value);
+  } catch (...) {
+    clear_memory();
+    throw;
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>& Deque<T, Allocator, BlockPolicy>::operator=(
+    const Deque& deque) {
+  if (this == &deque) {
+    return *this;
+  }
+  Deque temporary(
+      deque, AllocTraits::propagate_on_container_copy_assignment::value
+                 ? deque.alloc_
+                 : alloc_);
+  swap_deques(temporary);
   return *this;
 }
-template <typename T>
-Deque<T>::~Deque() {
-  for (size_t i = 0; i < size_; i++) {
-    operator[](i).~T();
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>& Deque<T, Allocator, BlockPolicy>::operator=(
+    Deque&& deque) noexcept(
+    AllocTraits::propagate_on_container_move_assignment::value ||
+    AllocTraits::is_always_equal::value) {
+  if (AllocTraits::propagate_on_container_move_assignment::value ||
+      alloc_ == deque.alloc_) {
+    Deque temporary(std::move(deque));
+    swap_contents(temporary);
+    if (AllocTraits::propagate_on_container_move_assignment::value) {
+      std::swap(alloc_, temporary.alloc_);
+    }
+  } else {
+    Deque temporary(alloc_);
+    temporary.append_range(std::make_move_iterator(deque.begin()),
+                           std::make_move_iterator(deque.end()));
+    swap_contents(temporary);
   }
-  for (size_t i = 0; i < allocated_blocks_; i++) {
-    delete[] reinterpret_cast<char*>(deque_[i]);
+  return *this;
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+Deque<T, Allocator, BlockPolicy>::~Deque() {
+  clear_memory();
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::swap(Deque& deque) noexcept {
+  if (AllocTraits::propagate_on_container_swap::value) {
+    std::swap(alloc_, deque.alloc_);
   }
+  swap_contents(deque);
 }
 
-template <typename T>
-size_t Deque<T>::size() const {
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t Deque<T, Allocator, BlockPolicy>::size() const {
   return size_;
 }
 
-template <typename T>
-T& Deque<T>::operator[](size_t index) {
-  return deque_[(start_ + index) / kBase][(start_ + index) % kBase];
+template <typename T, typename Allocator, typename BlockPolicy>
+T& Deque<T, Allocator, BlockPolicy>::operator[](size_t index) {
+  return map_[(start_ + index) / kBase][(start_ + index) % kBase];
 }
-template <typename T>
-const T& Deque<T>::operator[](size_t index) const {
-  return deque_[(start_ + index) / kBase][(start_ + index) % kBase];
+template <typename T, typename Allocator, typename BlockPolicy>
+const T& Deque<T, Allocator, BlockPolicy>::operator[](size_t index) const {
+  return map_[(start_ + index) / kBase][(start_ + index) % kBase];
 }
-template <typename T>
-T& Deque<T>::at(ssize_t index) {
+template <typename T, typename Allocator, typename BlockPolicy>
+T& Deque<T, Allocator, BlockPolicy>::at(ssize_t index) {
   if (index < 0 or index >= static_cast<ssize_t>(size_)) {
     throw std::out_of_range("");
   }
-  return deque_[block(start_ + index)][(start_ + index) % kBase];
+  return map_[block(start_ + index)][(start_ + index) % kBase];
 }
-template <typename T>
-const T& Deque<T>::at(ssize_t index) const {
+template <typename T, typename Allocator, typename BlockPolicy>
+const T& Deque<T, Allocator, BlockPolicy>::at(ssize_t index) const {
   if (index < 0 or index >= size_) {
     throw std::out_of_range("");
   }
-  return deque_[block(start_ + index)][(start_ + index) % kBase];
+  return map_[block(start_ + index)][(start_ + index) % kBase];
 }
 
-template <typename T>
-void Deque<T>::push_back(const T& value) {
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::push_back(const T& value) {
+  emplace_back(value);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename... Args>
+T& Deque<T, Allocator, BlockPolicy>::emplace_back(Args&&... args) {
+  if (block(start_ + size_) + 1 >= map_size_) {
+    make_back_room(1);
+  }
+  size_t index = start_ + size_;
+  T*& block_ptr = map_[block(index)];
+  bool fresh_block = (block_ptr == nullptr);
+  if (fresh_block) {
+    block_ptr = acquire_block();
+  }
+  T* place = block_ptr + index % kBase;
   try {
-    if (allocated_blocks_ == 0) {
-      zero_allocation();
-    }
-    if (last_used_block(size_) + 1 == allocated_blocks_ and
-        last_in_block(last_used_block(size_), size_) == (kBase - 1)) {
-      memory_allocation();
-    }
+    AllocTraits::construct(alloc_, place, std::forward<Args>(args)...);
   } catch (...) {
+    if (fresh_block) {
+      release_block(block_ptr);
+    }
     throw;
   }
-  new (deque_[last_used_block(size_ + 1)] +
-       last_in_block(last_used_block(size_ + 1), size_ + 1)) T(value);
   size_++;
+  return *place;
 }
-template <typename T>
-void Deque<T>::pop_back() {
-  (deque_[last_used_block(size_)] +
-   last_in_block(last_used_block(size_), size_))
-      ->~T();
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::pop_back() {
   size_--;
+  size_t index = start_ + size_;
+  T*& block_ptr = map_[block(index)];
+  AllocTraits::destroy(alloc_, block_ptr + index % kBase);
+  if (index % kBase == 0 or size_ == 0) {
+    release_block(block_ptr);
+    auto_trim();
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::push_front(const T& value) {
+  emplace_front(value);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::push_front(T&& value) {
+  emplace_front(std::move(value));
 }
-template <typename T>
-void Deque<T>::push_front(const T& value) {
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename... Args>
+T& Deque<T, Allocator, BlockPolicy>::emplace_front(Args&&... args) {
+  if (start_ == 0) {
+    make_front_room(1);
+  }
+  size_t index = start_ - 1;
+  T*& block_ptr = map_[block(index)];
+  bool fresh_block = (block_ptr == nullptr);
+  if (fresh_block) {
+    block_ptr = acquire_block();
+  }
+  T* place = block_ptr + index % kBase;
   try {
-    if (allocated_blocks_ == 0) {
-      zero_allocation();
-    }
-    if (start_ == 0) {
-      memory_allocation();
-    }
+    AllocTraits::construct(alloc_, place, std::forward<Args>(args)...);
   } catch (...) {
+    if (fresh_block) {
+      release_block(block_ptr);
+    }
     throw;
   }
   size_++;
   start_--;
-  new (deque_[block(start_)] + first_in_block(block(start_))) T(value);
+  return *place;
 }
-template <typename T>
-void Deque<T>::pop_front() {
-  (deque_[block(start_)] + first_in_block(block(start_)))->~T();
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::pop_front() {
+  T*& block_ptr = map_[block(start_)];
+  AllocTraits::destroy(alloc_, block_ptr + start_ % kBase);
   size_--;
   start_++;
+  if (start_ % kBase == 0 or size_ == 0) {
+    release_block(block_ptr);
+    auto_trim();
+  }
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename InputIt>
+void Deque<T, Allocator, BlockPolicy>::append_range(InputIt first,
+                                                    InputIt last) {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+    construct_back(std::distance(first, last), copy_construct(first));
+  } else {
+    size_t size = size_;
+    try {
+      for (; first != last; ++first) {
+        emplace_back(*first);
+      }
+    } catch (...) {
+      while (size_ > size) {
+        pop_back();
+      }
+      throw;
+    }
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename Range>
+void Deque<T, Allocator, BlockPolicy>::append_range(Range&& range) {
+  append_range(std::begin(range), std::end(range));
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename InputIt>
+void Deque<T, Allocator, BlockPolicy>::prepend_range(InputIt first,
+                                                     InputIt last) {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+    construct_front(std::distance(first, last), copy_construct(first));
+  } else {
+    size_t size = size_;
+    try {
+      for (; first != last; ++first) {
+        emplace_front(*first);
+      }
+    } catch (...) {
+      while (size_ > size) {
+        pop_front();
+      }
+      throw;
+    }
+    std::reverse(begin(), begin() + static_cast<int>(size_ - size));
+  }
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename Range>
+void Deque<T, Allocator, BlockPolicy>::prepend_range(Range&& range) {
+  prepend_range(std::begin(range), std::end(range));
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename InputIt, typename>
+void Deque<T, Allocator, BlockPolicy>::assign(InputIt first, InputIt last) {
+  clear();
+  append_range(first, last);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::assign(size_t count, const T& value) {
+  clear();
+  construct_back(count, fill_construct(value));
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::resize(size_t count) {
+  while (size_ > count) {
+    pop_back();
+  }
+  construct_back(count - size_, value_construct());
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::resize(size_t count, const T& value) {
+  while (size_ > count) {
+    pop_back();
+  }
+  construct_back(count - size_, fill_construct(value));
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::clear() {
+  while (size_ > 0) {
+    pop_back();
+  }
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::reserve_back(size_t count) {
+  if (size_ == 0) {
+    start_ -= start_ % kBase;
+  }
+  size_t end = start_ + size_;
+  size_t in_block = (end % kBase == 0 ? 0 : kBase - end % kBase);
+  size_t blocks =
+      (count > in_block ? (count - in_block + kBase - 1) / kBase : 0);
+  make_back_room(blocks);
+  reserve_spare_blocks(blocks);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::reserve_front(size_t count) {
+  if (size_ == 0) {
+    start_ -= start_ % kBase;
+  }
+  size_t in_block = start_ % kBase;
+  size_t blocks =
+      (count > in_block ? (count - in_block + kBase - 1) / kBase : 0);
+  make_front_room(blocks);
+  reserve_spare_blocks(blocks);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t Deque<T, Allocator, BlockPolicy>::capacity_back() const {
+  if (map_ == nullptr) {
+    return 0;
+  }
+  size_t end = start_ + size_;
+  size_t fresh_from = block(end) + (map_[block(end)] != nullptr ? 1 : 0);
+  size_t fresh = std::min(spare_count_, map_size_ - 1 - fresh_from);
+  size_t covered = (fresh_from + fresh) * kBase;
+  return (covered > end ? covered - end : 0);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t Deque<T, Allocator, BlockPolicy>::capacity_front() const {
+  if (map_ == nullptr) {
+    return 0;
+  }
+  size_t fresh_to = block(start_);
+  if (map_[fresh_to] == nullptr and start_ % kBase != 0) {
+    fresh_to++;
+  }
+  size_t covered = (fresh_to - std::min(spare_count_, fresh_to)) * kBase;
+  return (start_ > covered ? start_ - covered : 0);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t Deque<T, Allocator, BlockPolicy>::allocated_bytes() const {
+  size_t blocks = end_used_block() - first_used_block() + spare_count_;
+  return blocks * kBlockBytes + map_size_ * sizeof(T*);
 }
 
-template <typename T>
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::shrink_to_fit() {
+  free_spare_blocks();
+  if (size_ == 0) {
+    deallocate_map();
+    start_ = 0;
+    return;
+  }
+  size_t first = first_used_block();
+  size_t last = end_used_block();
+  if (map_size_ == last - first + 1) {
+    return;
+  }
+  T** map = allocate_map(last - first + 1);
+  std::copy(map_ + first, map_ + last, map);
+  deallocate_map();
+  map_ = map;
+  map_size_ = last - first + 1;
+  start_ -= first * kBase;
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::trim(size_t max_spare_blocks) {
+  free_spare_blocks(max_spare_blocks);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::set_auto_trim(double min_occupancy) {
+  min_occupancy_ = min_occupancy;
+  auto_trim();
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
 template <bool IsConst>
-class Deque<T>::common_iterator {
+class Deque<T, Allocator, BlockPolicy>::common_iterator {
  public:
   using value_type = std::conditional_t<IsConst, const T, T>;
   using difference_type = long long;
@@ -311,54 +919,79 @@ class Deque<T>::common_iterator {
   using iterator_category = std::random_access_iterator_tag;
   using block_pointer = std::conditional_t<IsConst, T* const*, T**>;
 
-  common_iterator(block_pointer block, long long index)
-      : block_(block), index_(index) {}
-  operator const_iterator() { return const_iterator(*this); }
+  common_iterator() = default;
+  common_iterator(block_pointer node, pointer current) {
+    set_node(node);
+    cur_ = current;
+  }
+  operator const_iterator() const { return const_iterator(node_, cur_); }
 
-  reference operator*() { return (*block_)[index_]; }
-  pointer operator->() { return &((*block_)[index_]); }
+  reference operator*() const { return *cur_; }
+  pointer operator->() const { return cur_; }
+  reference operator[](difference_type number) const {
+    return *(*this + number);
+  }
 
-  common_iterator& operator+=(int number) {
-    block_ += (index_ + number) / kBase;
-    index_ = (index_ + number) % kBase;
-    if (index_ < 0) {
-      --block_;
-      index_ += kBase;
+  common_iterator& operator+=(difference_type number) {
+    difference_type offset = number + (cur_ - first_);
+    if (offset >= 0 and offset < kBase) {
+      cur_ += number;
+      return *this;
     }
+    difference_type node_offset =
+        (offset > 0 ? offset / kBase : -((-offset - 1) / kBase) - 1);
+    set_node(node_ + node_offset);
+    cur_ = first_ + (offset - node_offset * kBase);
     return *this;
   }
-  common_iterator& operator-=(int number) {
+  common_iterator& operator-=(difference_type number) {
     *this += (-number);
     return *this;
   }
 
-  common_iterator operator+(int number) const {
+  common_iterator operator+(difference_type number) const {
     auto it_copy = *this;
     it_copy += number;
     return it_copy;
   }
-  common_iterator operator-(int number) const {
+  friend common_iterator operator+(difference_type number,
+                                   const common_iterator& iter) {
+    return iter + number;
+  }
+  common_iterator operator-(difference_type number) const {
     auto it_copy = *this;
     it_copy -= number;
     return it_copy;
   }
 
-  common_iterator& operator++() { return (*this += 1); }
+  common_iterator& operator++() {
+    if (++cur_ == last_) {
+      set_node(node_ + 1);
+      cur_ = first_;
+    }
+    return *this;
+  }
   common_iterator operator++(int) {
     auto iter = *this;
-    *this += 1;
+    ++*this;
     return (iter);
   }
-  common_iterator& operator--() { return (*this -= 1); }
+  common_iterator& operator--() {
+    if (cur_ == first_) {
+      set_node(node_ - 1);
+      cur_ = last_;
+    }
+    --cur_;
+    return *this;
+  }
   common_iterator operator--(int) {
     auto iter = *this;
-    *this -= 1;
+    --*this;
     return (iter);
   }
 
   bool operator<(const common_iterator& iter) const {
-    return (block_ < iter.block_ or
-            (block_ == iter.block_ and index_ < iter.index_));
+    return (node_ == iter.node_ ? cur_ < iter.cur_ : node_ < iter.node_);
   }
   bool operator>(const common_iterator& iter) const { return iter < (*this); }
   bool operator<=(const common_iterator& iter) const {
@@ -368,43 +1001,314 @@ class Deque<T>::common_iterator {
     return !((*this) < iter);
   }
   bool operator==(const common_iterator& iter) const {
-    return (block_ == iter.block_ and index_ == iter.index_);
+    return cur_ == iter.cur_;
   }
   bool operator!=(const common_iterator& iter) const {
     return !((*this) == iter);
   }
 
   difference_type operator-(const common_iterator& iter) const {
-    return (block_ - iter.block_) * kBase + index_ - iter.index_;
+    return (node_ - iter.node_) * kBase + (cur_ - first_) -
+           (iter.cur_ - iter.first_);
+  }
+
+  // Hands the range [*this, last) to `visitor` one contiguous block span at
+  // a time. The visitor returns the pointer where it stopped; a stop before
+  // the end of the span ends the walk and the matching iterator is
+  // returned, otherwise the walk returns last.
+  template <typename Visitor>
+  common_iterator walk_segments(const common_iterator& last,
+                                Visitor visitor) const {
+    common_iterator current = *this;
+    while (current.node_ != last.node_) {
+      pointer stop = visitor(current.cur_, current.last_);
+      if (stop != current.last_) {
+        return common_iterator(current.node_, stop);
+      }
+      current.set_node(current.node_ + 1);
+      current.cur_ = current.first_;
+    }
+    if (current.cur_ == last.cur_) {
+      return last;
+    }
+    return common_iterator(current.node_, visitor(current.cur_, last.cur_));
   }
 
  private:
-  block_pointer block_;
-  long long index_ = 0;
+  // Classic segmented layout: the current element plus the bounds of its
+  // block, so ++, -- and * only touch the map when a block edge is
+  // crossed. The block after the last element may be absent from the map;
+  // end() then sits on it with all three pointers null.
+  pointer cur_ = nullptr;
+  pointer first_ = nullptr;
+  pointer last_ = nullptr;
+  block_pointer node_ = nullptr;
+
+  friend class Deque;
+
+  void set_node(block_pointer node) {
+    node_ = node;
+    first_ = *node;
+    last_ = (first_ == nullptr ? nullptr : first_ + kBase);
+  }
 };
 
-template <typename T>
-void Deque<T>::insert(iterator iter, const T& element) {
-  size_t size1 = iter - begin();
-  if (allocated_blocks_ == 0) {
-    zero_allocation();
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::insert(iterator iter, const T& element) {
+  emplace(iter, element);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::insert(iterator iter, T&& element) {
+  emplace(iter, std::move(element));
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename InputIt, typename>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::insert(iterator iter, InputIt first,
+                                         InputIt last) {
+  size_t index = iter - begin();
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+    return insert_range(index, first, std::distance(first, last));
+  } else {
+    Deque temporary(alloc_);
+    temporary.append_range(first, last);
+    return insert_range(index, std::make_move_iterator(temporary.begin()),
+                        temporary.size());
   }
-  if (last_used_block(size_) + 1 == allocated_blocks_ and
-      last_in_block(last_used_block(size_), size_) == (kBase - 1)) {
-    memory_allocation();
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename... Args>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::emplace(iterator iter, Args&&... args) {
+  long long index = iter - begin();
+  if (index == 0) {
+    emplace_front(std::forward<Args>(args)...);
+    return begin();
   }
-  iter = iterator(&deque_[(start_ + size1) / kBase], (start_ + size1) % kBase);
-  for (auto cur_it = end(); cur_it > iter; cur_it--) {
-    *cur_it = *(cur_it - 1);
+  if (index == static_cast<long long>(size_)) {
+    emplace_back(std::forward<Args>(args)...);
+    return begin() + index;
   }
-  *iter = T(element);
-  size_++;
+  T element(std::forward<Args>(args)...);
+  return insert_range(index, std::make_move_iterator(&element), 1);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void Deque<T, Allocator, BlockPolicy>::erase(iterator iter) {
+  erase(iter, iter + 1);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::erase(iterator first, iterator last) {
+  size_t index = first - begin();
+  size_t count = last - first;
+  if (count == 0) {
+    return first;
+  }
+  if (index < size_ - index - count) {
+    move_backward(begin(), first, last);
+    for (size_t i = 0; i < count; i++) {
+      pop_front();
+    }
+  } else {
+    move_forward(last, end(), first);
+    for (size_t i = 0; i < count; i++) {
+      pop_back();
+    }
+  }
+  return begin() + index;
+}
+
+// Opens a gap of `count` slots at `index` by moving the shorter side
+// outwards: elements that land in fresh slots are move-constructed, the
+// rest are move-assigned, and the gap is filled from `first` by
+// construction where it overlaps fresh slots and by assignment elsewhere.
+// Each existing element is moved exactly once.
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename ForwardIt>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::insert_range(size_t index, ForwardIt first,
+                                                size_t count) {
+  if (count == 0) {
+    return begin() + index;
+  }
+  if (index < size_ - index) {
+    reserve_front(count);
+    size_t from = start_ - count;
+    size_t moved = std::min(count, index);
+    fill_map(block(from), block(start_));
+    try {
+      auto source = std::make_move_iterator(begin());
+      construct_segments(from, moved, copy_construct(source));
+      try {
+        construct_segments(from + moved, count - moved, copy_construct(first));
+      } catch (...) {
+        destroy_range(from, moved);
+        throw;
+      }
+    } catch (...) {
+      drain_map(block(from), block(start_));
+      throw;
+    }
+    start_ = from;
+    size_ += count;
+    if (moved == count) {
+      move_forward(begin() + 2 * count, begin() + (count + index),
+                   begin() + count);
+      std::copy_n(first, count, begin() + index);
+    } else {
+      std::copy_n(first, index, begin() + count);
+    }
+    return begin() + index;
+  }
+  size_t size = size_;
+  size_t after = size - index;
+  reserve_back(count);
+  size_t from = start_ + size;
+  size_t first_fresh = block(from + kBase - 1);
+  size_t last_fresh = block(from + count - 1) + 1;
+  fill_map(first_fresh, last_fresh);
+  try {
+    if (after >= count) {
+      auto source = std::make_move_iterator(end() - count);
+      construct_segments(from, count, copy_construct(source));
+    } else {
+      ForwardIt tail = std::next(first, after);
+      construct_segments(from, count - after, copy_construct(tail));
+      try {
+        auto source = std::make_move_iterator(begin() + index);
+        construct_segments(from + count - after, after, copy_construct(source));
+      } catch (...) {
+        destroy_range(from, count - after);
+        throw;
+      }
+    }
+  } catch (...) {
+    drain_map(first_fresh, last_fresh);
+    throw;
+  }
+  size_ += count;
+  if (after >= count) {
+    move_backward(begin() + index, begin() + (size - count), begin() + size);
+    std::copy_n(first, count, begin() + index);
+  } else {
+    std::copy_n(first, after, begin() + index);
+  }
+  return begin() + index;
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::move_forward(iterator first, iterator last,
+                                                iterator dest) {
+  while (first != last) {
+    long long chunk = std::min<long long>(
+        {last - first, first.last_ - first.cur_, dest.last_ - dest.cur_});
+    std::move(first.cur_, first.cur_ + chunk, dest.cur_);
+    first += chunk;
+    dest += chunk;
+  }
+  return dest;
 }
 
-template <typename T>
-void Deque<T>::erase(Deque<T>::iterator iter) {
-  for (auto cur_it = iter; cur_it < end() - 1; cur_it++) {
-    *cur_it = *(cur_it + 1);
+template <typename T, typename Allocator, typename BlockPolicy>
+typename Deque<T, Allocator, BlockPolicy>::iterator
+Deque<T, Allocator, BlockPolicy>::move_backward(iterator first, iterator last,
+                                                 iterator dest_last) {
+  while (first != last) {
+    T* source_end = last.cur_;
+    long long source_size = last.cur_ - last.first_;
+    if (source_size == 0) {
+      source_end = *(last.node_ - 1) + kBase;
+      source_size = kBase;
+    }
+    T* dest_end = dest_last.cur_;
+    long long dest_size = dest_last.cur_ - dest_last.first_;
+    if (dest_size == 0) {
+      dest_end = *(dest_last.node_ - 1) + kBase;
+      dest_size = kBase;
+    }
+    long long chunk =
+        std::min<long long>({last - first, source_size, dest_size});
+    std::move_backward(source_end - chunk, source_end, dest_end);
+    last -= chunk;
+    dest_last -= chunk;
   }
-  pop_back();
+  return dest_last;
 }
+
+// Algorithms over Deque iterator ranges that process the block map one
+// contiguous [T*, T*) span at a time, so the inner loops are plain pointer
+// loops the compiler can vectorize instead of a divide per increment.
+namespace segmented {
+
+template <typename Iterator, typename Function>
+Function for_each_segment(Iterator first, Iterator last, Function function) {
+  first.walk_segments(last, [&function](auto begin, auto end) {
+    function(begin, end);
+    return end;
+  });
+  return function;
+}
+
+template <typename Iterator, typename Function>
+Function for_each(Iterator first, Iterator last, Function function) {
+  first.walk_segments(last, [&function](auto begin, auto end) {
+    for (; begin != end; ++begin) {
+      function(*begin);
+    }
+    return end;
+  });
+  return function;
+}
+
+template <typename Iterator, typename OutputIt>
+OutputIt copy(Iterator first, Iterator last, OutputIt output) {
+  first.walk_segments(last, [&output](auto begin, auto end) {
+    output = std::copy(begin, end, output);
+    return end;
+  });
+  return output;
+}
+
+template <typename Iterator, typename T>
+void fill(Iterator first, Iterator last, const T& value) {
+  first.walk_segments(last, [&value](auto begin, auto end) {
+    std::fill(begin, end, value);
+    return end;
+  });
+}
+
+template <typename Iterator, typename T>
+Iterator find(Iterator first, Iterator last, const T& value) {
+  return first.walk_segments(last, [&value](auto begin, auto end) {
+    return std::find(begin, end, value);
+  });
+}
+
+template <typename Iterator, typename T>
+long long count(Iterator first, Iterator last, const T& value) {
+  long long result = 0;
+  first.walk_segments(last, [&result, &value](auto begin, auto end) {
+    result += std::count(begin, end, value);
+    return end;
+  });
+  return result;
+}
+
+template <typename Iterator, typename T, typename BinaryOperation = std::plus<>>
+T accumulate(Iterator first, Iterator last, T init,
+             BinaryOperation operation = BinaryOperation()) {
+  first.walk_segments(last, [&init, &operation](auto begin, auto end) {
+    init = std::accumulate(begin, end, std::move(init), operation);
+    return end;
+  });
+  return init;
+}
+
+}  // namespace segmented
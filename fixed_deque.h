@@ -0,0 +1,397 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Deque with a compile-time capacity and no heap allocation: elements live in
+// an inline ring of Capacity slots (a power of two), so every index is a
+// mask instead of a division and the whole container can sit on the stack or
+// inside a StackStorage. try_push_* report a full ring by returning false;
+// push_* and emplace_* throw std::length_error instead.
+template <typename T, size_t Capacity>
+class FixedDeque {
+  static_assert(Capacity > 0 and (Capacity & (Capacity - 1)) == 0,
+                "FixedDeque capacity must be a power of two");
+
+ public:
+  FixedDeque() = default;
+  FixedDeque(const FixedDeque& deque);
+  FixedDeque(FixedDeque&& deque) noexcept(
+      std::is_nothrow_move_constructible_v<T>);
+  FixedDeque(int size);
+  FixedDeque(int size, const T& value);
+  FixedDeque& operator=(const FixedDeque& deque);
+  FixedDeque& operator=(FixedDeque&& deque) noexcept(
+      std::is_nothrow_move_constructible_v<T>);
+  ~FixedDeque();
+
+  void swap(FixedDeque& deque);
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] bool full() const { return size_ == Capacity; }
+  static constexpr size_t capacity() { return Capacity; }
+
+  T& operator[](size_t index) { return slot(head_ + index); }
+  const T& operator[](size_t index) const { return slot(head_ + index); }
+  T& at(ssize_t index);
+  const T& at(ssize_t index) const;
+
+  void push_back(const T& value);
+  void push_back(T&& value);
+  void pop_back();
+  void push_front(const T& value);
+  void push_front(T&& value);
+  void pop_front();
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  template <typename... Args>
+  T& emplace_front(Args&&... args);
+
+  bool try_push_back(const T& value);
+  bool try_push_back(T&& value);
+  bool try_push_front(const T& value);
+  bool try_push_front(T&& value);
+
+  void clear();
+
+  template <bool IsConst>
+  class common_iterator;
+
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  iterator begin() { return iterator(data(), head_); }
+  const_iterator begin() const { return const_iterator(data(), head_); }
+  iterator end() { return iterator(data(), head_ + size_); }
+  const_iterator end() const { return const_iterator(data(), head_ + size_); }
+
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return std::make_reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return std::make_reverse_iterator(cend());
+  }
+  const_reverse_iterator crbegin() const {
+    return std::make_reverse_iterator(cend());
+  }
+
+  reverse_iterator rend() { return std::make_reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return std::make_reverse_iterator(cbegin());
+  }
+  const_reverse_iterator crend() const {
+    return std::make_reverse_iterator(cbegin());
+  }
+
+ private:
+  static constexpr size_t kMask = Capacity - 1;
+
+  // Ring positions are kept unmasked and wrap around modulo 2^64, which is
+  // a multiple of Capacity, so `& kMask` always finds the right slot.
+  alignas(T) unsigned char storage_[Capacity * sizeof(T)];
+  size_t head_{0};
+  size_t size_{0};
+
+  T* data() { return reinterpret_cast<T*>(storage_); }
+  const T* data() const { return reinterpret_cast<const T*>(storage_); }
+  T& slot(size_t position) { return data()[position & kMask]; }
+  const T& slot(size_t position) const { return data()[position & kMask]; }
+
+  void append_all(const FixedDeque& deque);
+  void take_all(FixedDeque& deque);
+};
+
+template <typename T, size_t Capacity>
+template <bool IsConst>
+class FixedDeque<T, Capacity>::common_iterator {
+ public:
+  using value_type = std::conditional_t<IsConst, const T, T>;
+  using difference_type = long long;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using iterator_category = std::random_access_iterator_tag;
+
+  common_iterator() = default;
+  common_iterator(pointer data, size_t position)
+      : data_(data), position_(position) {}
+  operator const_iterator() const { return const_iterator(data_, position_); }
+
+  reference operator*() const { return data_[position_ & kMask]; }
+  pointer operator->() const { return data_ + (position_ & kMask); }
+  reference operator[](difference_type number) const {
+    return data_[(position_ + number) & kMask];
+  }
+
+  common_iterator& operator+=(difference_type number) {
+    position_ += number;
+    return *this;
+  }
+  common_iterator& operator-=(difference_type number) {
+    position_ -= number;
+    return *this;
+  }
+
+  common_iterator operator+(difference_type number) const {
+    return common_iterator(data_, position_ + number);
+  }
+  friend common_iterator operator+(difference_type number,
+                                   const common_iterator& iter) {
+    return iter + number;
+  }
+  common_iterator operator-(difference_type number) const {
+    return common_iterator(data_, position_ - number);
+  }
+
+  common_iterator& operator++() {
+    ++position_;
+    return *this;
+  }
+  common_iterator operator++(int) {
+    auto iter = *this;
+    ++position_;
+    return iter;
+  }
+  common_iterator& operator--() {
+    --position_;
+    return *this;
+  }
+  common_iterator operator--(int) {
+    auto iter = *this;
+    --position_;
+    return iter;
+  }
+
+  difference_type operator-(const common_iterator& iter) const {
+    return static_cast<difference_type>(position_ - iter.position_);
+  }
+
+  bool operator<(const common_iterator& iter) const {
+    return (*this - iter) < 0;
+  }
+  bool operator>(const common_iterator& iter) const { return iter < (*this); }
+  bool operator<=(const common_iterator& iter) const {
+    return !((*this) > iter);
+  }
+  bool operator>=(const common_iterator& iter) const {
+    return !((*this) < iter);
+  }
+  bool operator==(const common_iterator& iter) const {
+    return position_ == iter.position_;
+  }
+  bool operator!=(const common_iterator& iter) const {
+    return !((*this) == iter);
+  }
+
+ private:
+  pointer data_ = nullptr;
+  size_t position_ = 0;
+};
+
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>::FixedDeque(const FixedDeque& deque) {
+  append_all(deque);
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>::FixedDeque(FixedDeque&& deque) noexcept(
+    std::is_nothrow_move_constructible_v<T>) {
+  take_all(deque);
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>::FixedDeque(int size) {
+  try {
+    for (int i = 0; i < size; i++) {
+      emplace_back();
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>::FixedDeque(int size, const T& value) {
+  try {
+    for (int i = 0; i < size; i++) {
+      emplace_back(value);
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>& FixedDeque<T, Capacity>::operator=(
+    const FixedDeque& deque) {
+  if (this == &deque) {
+    return *this;
+  }
+  FixedDeque temporary(deque);
+  clear();
+  take_all(temporary);
+  return *this;
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>& FixedDeque<T, Capacity>::operator=(
+    FixedDeque&& deque) noexcept(std::is_nothrow_move_constructible_v<T>) {
+  if (this == &deque) {
+    return *this;
+  }
+  clear();
+  take_all(deque);
+  return *this;
+}
+template <typename T, size_t Capacity>
+FixedDeque<T, Capacity>::~FixedDeque() {
+  clear();
+}
+
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::swap(FixedDeque& deque) {
+  FixedDeque temporary(std::move(deque));
+  deque = std::move(*this);
+  *this = std::move(temporary);
+}
+
+template <typename T, size_t Capacity>
+T& FixedDeque<T, Capacity>::at(ssize_t index) {
+  if (index < 0 or index >= static_cast<ssize_t>(size_)) {
+    throw std::out_of_range("");
+  }
+  return slot(head_ + index);
+}
+template <typename T, size_t Capacity>
+const T& FixedDeque<T, Capacity>::at(ssize_t index) const {
+  if (index < 0 or index >= static_cast<ssize_t>(size_)) {
+    throw std::out_of_range("");
+  }
+  return slot(head_ + index);
+}
+
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::push_back(const T& value) {
+  emplace_back(value);
+}
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+template <typename T, size_t Capacity>
+template <typename... Args>
+T& FixedDeque<T, Capacity>::emplace_back(Args&&... args) {
+  if (size_ == Capacity) {
+    throw std::length_error("FixedDeque is full");
+  }
+  T* place = &slot(head_ + size_);
+  new (place) T(std::forward<Args>(args)...);
+  size_++;
+  return *place;
+}
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::pop_back() {
+  size_--;
+  std::destroy_at(&slot(head_ + size_));
+}
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::push_front(const T& value) {
+  emplace_front(value);
+}
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::push_front(T&& value) {
+  emplace_front(std::move(value));
+}
+template <typename T, size_t Capacity>
+template <typename... Args>
+T& FixedDeque<T, Capacity>::emplace_front(Args&&... args) {
+  if (size_ == Capacity) {
+    throw std::length_error("FixedDeque is full");
+  }
+  T* place = &slot(head_ - 1);
+  new (place) T(std::forward<Args>(args)...);
+  head_--;
+  size_++;
+  return *place;
+}
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::pop_front() {
+  std::destroy_at(&slot(head_));
+  head_++;
+  size_--;
+}
+
+template <typename T, size_t Capacity>
+bool FixedDeque<T, Capacity>::try_push_back(const T& value) {
+  if (size_ == Capacity) {
+    return false;
+  }
+  emplace_back(value);
+  return true;
+}
+template <typename T, size_t Capacity>
+bool FixedDeque<T, Capacity>::try_push_back(T&& value) {
+  if (size_ == Capacity) {
+    return false;
+  }
+  emplace_back(std::move(value));
+  return true;
+}
+template <typename T, size_t Capacity>
+bool FixedDeque<T, Capacity>::try_push_front(const T& value) {
+  if (size_ == Capacity) {
+    return false;
+  }
+  emplace_front(value);
+  return true;
+}
+template <typename T, size_t Capacity>
+bool FixedDeque<T, Capacity>::try_push_front(T&& value) {
+  if (size_ == Capacity) {
+    return false;
+  }
+  emplace_front(std::move(value));
+  return true;
+}
+
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::clear() {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (size_t i = 0; i < size_; i++) {
+      std::destroy_at(&slot(head_ + i));
+    }
+  }
+  head_ = 0;
+  size_ = 0;
+}
+
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::append_all(const FixedDeque& deque) {
+  try {
+    for (size_t i = 0; i < deque.size_; i++) {
+      emplace_back(deque[i]);
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+// Moves every element of `deque` into this empty deque and empties it.
+template <typename T, size_t Capacity>
+void FixedDeque<T, Capacity>::take_all(FixedDeque& deque) {
+  try {
+    for (size_t i = 0; i < deque.size_; i++) {
+      emplace_back(std::move(deque[i]));
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+  deque.clear();
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "stackallocator.h"
+
+// Least-recently-used cache. Entries live in a List kept in recency order
+// (most recent first); a hit splices the entry's node to the front, so no
+// entry is ever copied or reallocated after insertion. Keys are found
+// through an open-addressing table of list iterators with linear probing
+// and backward-shift deletion, so get, put and evict are O(1).
+//
+// The capacity is a total weight: by default every entry weighs 1 and the
+// capacity counts entries; a weigher (e.g. returning the value's byte size)
+// turns it into a byte budget. Entries evicted to make room are passed to
+// the eviction callback first. Both the list nodes and the table come from
+// Allocator, so a cache can live entirely in a StackStorage.
+template <typename K, typename V,
+          typename Allocator = std::allocator<std::pair<K, V>>,
+          typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class LruCache {
+ public:
+  using Weigher = std::function<size_t(const K&, const V&)>;
+  using EvictionCallback = std::function<void(const K&, V&)>;
+
+  struct Entry {
+    K key;
+    V value;
+    size_t weight;
+  };
+
+ private:
+  using EntryAlloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>;
+  using Order = List<Entry, EntryAlloc>;
+
+ public:
+  using const_iterator = typename Order::const_iterator;
+
+  explicit LruCache(size_t capacity, const Allocator& alloc = Allocator())
+      : LruCache(capacity, Weigher(), alloc) {}
+  LruCache(size_t capacity, Weigher weigher,
+           const Allocator& alloc = Allocator());
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  void set_eviction_callback(EvictionCallback callback) {
+    on_evict_ = std::move(callback);
+  }
+
+  // Returns the cached value and marks it most recently used, or nullptr.
+  V* get(const K& key);
+  // Like get(), without touching the recency order.
+  const V* peek(const K& key) const;
+  [[nodiscard]] bool contains(const K& key) const {
+    return find(key, hash_(key)) != kNotFound;
+  }
+
+  // Inserts or replaces the value for `key` as the most recently used entry
+  // and evicts from the least recently used end until the cache fits. A
+  // value heavier than the whole capacity goes straight to the eviction
+  // callback; it only drops the old entry for `key`, not the others.
+  void put(const K& key, V value);
+  bool erase(const K& key);
+  // Evicts the least recently used entry; the cache must not be empty.
+  void evict();
+  void clear();
+
+  [[nodiscard]] size_t size() const { return order_.size(); }
+  [[nodiscard]] bool empty() const { return order_.size() == 0; }
+  [[nodiscard]] size_t weight() const { return weight_; }
+  [[nodiscard]] size_t capacity() const { return capacity_; }
+  void set_capacity(size_t capacity);
+
+  // Entries from the most to the least recently used.
+  const_iterator begin() const { return order_.begin(); }
+  const_iterator end() const { return order_.end(); }
+
+ private:
+  using iterator = typename Order::iterator;
+
+  struct Slot {
+    // Hash of the key with kOccupied set; 0 marks an empty slot.
+    size_t hash;
+    iterator entry;
+  };
+  using SlotAlloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+
+  static constexpr size_t kOccupied = size_t(1) << (sizeof(size_t) * 8 - 1);
+  static constexpr size_t kNotFound = ~size_t(0);
+  static constexpr size_t kMinSlots = 16;
+
+  Order order_;
+  std::vector<Slot, SlotAlloc> slots_;
+  size_t shift_ = 0;
+  size_t capacity_;
+  size_t weight_ = 0;
+  Weigher weigh_;
+  EvictionCallback on_evict_;
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] KeyEqual equal_;
+
+  // Fibonacci hashing spreads poor hashes (such as the identity hash of
+  // integers) over the whole table.
+  size_t home(size_t hash) const {
+    return (hash * 0x9E3779B97F4A7C15ULL) >> shift_;
+  }
+  size_t next(size_t index) const { return (index + 1) & (slots_.size() - 1); }
+
+  size_t find(const K& key, size_t hash) const;
+  // Grows the table if one more entry would make it over half full. Called
+  // before the entry is added to order_, so a failed allocation leaves the
+  // cache unchanged.
+  void reserve_slot();
+  void insert_slot(size_t hash, iterator entry);
+  void erase_slot(size_t index);
+  void rehash(size_t slots);
+  void remove(iterator entry);
+  // Drops the entry of slot `index` without calling the eviction callback.
+  void erase_at(size_t index);
+  void shrink_to_capacity();
+};
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+LruCache<K, V, Allocator, Hash, KeyEqual>::LruCache(size_t capacity,
+                                                    Weigher weigher,
+                                                    const Allocator& alloc)
+    : order_(EntryAlloc(alloc)),
+      slots_(SlotAlloc(alloc)),
+      capacity_(capacity),
+      weigh_(std::move(weigher)) {
+  size_t slots = kMinSlots;
+  // An entry-counted cache holds at most capacity + 1 entries (during a
+  // put), so its table is sized for them here and only grows if
+  // set_capacity() raises the capacity. A weighted cache starts at
+  // kMinSlots and doubles as needed. The table never shrinks.
+  while (!weigh_ and slots < 2 * (capacity + 1)) {
+    slots *= 2;
+  }
+  rehash(slots);
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+size_t LruCache<K, V, Allocator, Hash, KeyEqual>::find(const K& key,
+                                                       size_t hash) const {
+  hash |= kOccupied;
+  for (size_t index = home(hash);; index = next(index)) {
+    const Slot& slot = slots_[index];
+    if (slot.hash == 0) {
+      return kNotFound;
+    }
+    if (slot.hash == hash and equal_(slot.entry->key, key)) {
+      return index;
+    }
+  }
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::reserve_slot() {
+  if (2 * (order_.size() + 1) > slots_.size()) {
+    rehash(2 * slots_.size());
+  }
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::insert_slot(size_t hash,
+                                                            iterator entry) {
+  hash |= kOccupied;
+  size_t index = home(hash);
+  while (slots_[index].hash != 0) {
+    index = next(index);
+  }
+  slots_[index] = Slot{hash, entry};
+}
+
+// Backward-shift deletion: later entries of the probe run move into the
+// hole when that brings them closer to their home slot, so lookups never
+// need tombstones.
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::erase_slot(size_t index) {
+  size_t mask = slots_.size() - 1;
+  size_t hole = index;
+  for (size_t probe = next(hole); slots_[probe].hash != 0;
+       probe = next(probe)) {
+    size_t distance_to_home = (probe - home(slots_[probe].hash)) & mask;
+    size_t distance_to_hole = (probe - hole) & mask;
+    if (distance_to_home >= distance_to_hole) {
+      slots_[hole] = slots_[probe];
+      hole = probe;
+    }
+  }
+  slots_[hole].hash = 0;
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::rehash(size_t slots) {
+  std::vector<Slot, SlotAlloc> old(slots, Slot{0, iterator()},
+                                   slots_.get_allocator());
+  old.swap(slots_);
+  shift_ = sizeof(size_t) * 8;
+  for (size_t size = 1; size < slots; size *= 2) {
+    shift_--;
+  }
+  for (const Slot& slot : old) {
+    if (slot.hash != 0) {
+      size_t index = home(slot.hash);
+      while (slots_[index].hash != 0) {
+        index = next(index);
+      }
+      slots_[index] = slot;
+    }
+  }
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+V* LruCache<K, V, Allocator, Hash, KeyEqual>::get(const K& key) {
+  size_t index = find(key, hash_(key));
+  if (index == kNotFound) {
+    return nullptr;
+  }
+  iterator entry = slots_[index].entry;
+  order_.splice(order_.begin(), order_, entry);
+  return &(*entry).value;
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+const V* LruCache<K, V, Allocator, Hash, KeyEqual>::peek(const K& key) const {
+  size_t index = find(key, hash_(key));
+  if (index == kNotFound) {
+    return nullptr;
+  }
+  return &slots_[index].entry->value;
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::put(const K& key, V value) {
+  size_t hash = hash_(key);
+  size_t weight = (weigh_ ? weigh_(key, value) : 1);
+  size_t index = find(key, hash);
+  if (weight > capacity_) {
+    if (index != kNotFound) {
+      erase_at(index);
+    }
+    if (on_evict_) {
+      on_evict_(key, value);
+    }
+    return;
+  }
+  if (index != kNotFound) {
+    iterator entry = slots_[index].entry;
+    weight_ = weight_ - (*entry).weight + weight;
+    (*entry).value = std::move(value);
+    (*entry).weight = weight;
+    order_.splice(order_.begin(), order_, entry);
+  } else {
+    reserve_slot();
+    order_.emplace_front(Entry{key, std::move(value), weight});
+    weight_ += weight;
+    insert_slot(hash, order_.begin());
+  }
+  shrink_to_capacity();
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::remove(iterator entry) {
+  erase_slot(find((*entry).key, hash_((*entry).key)));
+  weight_ -= (*entry).weight;
+  order_.erase(entry);
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+bool LruCache<K, V, Allocator, Hash, KeyEqual>::erase(const K& key) {
+  size_t index = find(key, hash_(key));
+  if (index == kNotFound) {
+    return false;
+  }
+  erase_at(index);
+  return true;
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::erase_at(size_t index) {
+  iterator entry = slots_[index].entry;
+  erase_slot(index);
+  weight_ -= (*entry).weight;
+  order_.erase(entry);
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::evict() {
+  iterator entry = order_.end();
+  --entry;
+  if (on_evict_) {
+    on_evict_((*entry).key, (*entry).value);
+  }
+  remove(entry);
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::shrink_to_capacity() {
+  while (weight_ > capacity_) {
+    evict();
+  }
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::set_capacity(size_t capacity) {
+  capacity_ = capacity;
+  shrink_to_capacity();
+}
+
+template <typename K, typename V, typename Allocator, typename Hash,
+          typename KeyEqual>
+void LruCache<K, V, Allocator, Hash, KeyEqual>::clear() {
+  while (order_.size() != 0) {
+    order_.pop_front();
+  }
+  for (Slot& slot : slots_) {
+    slot.hash = 0;
+  }
+  weight_ = 0;
+}
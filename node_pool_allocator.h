@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size node pool: nodes are carved in order out of slabs that grow
+// from kMinSlabNodes to kMaxSlabNodes nodes, and freed nodes are recycled
+// LIFO through an intrusive free list threaded through the nodes
+// themselves. Slabs are only returned when the pool is destroyed.
+class NodePool {
+ public:
+  static constexpr size_t kMinSlabNodes = 64;
+  static constexpr size_t kMaxSlabNodes = 4096;
+
+  explicit NodePool(size_t node_size) : node_size_(node_size) {}
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+  ~NodePool();
+
+  void* allocate() {
+    if (free_ != nullptr) {
+      void* node = free_;
+      free_ = *static_cast<void**>(node);
+      return node;
+    }
+    if (cursor_ == end_) {
+      add_slab();
+    }
+    void* node = cursor_;
+    cursor_ += node_size_;
+    return node;
+  }
+  void deallocate(void* node) {
+    *static_cast<void**>(node) = free_;
+    free_ = node;
+  }
+
+  [[nodiscard]] size_t node_size() const { return node_size_; }
+
+ private:
+  struct alignas(std::max_align_t) Slab {
+    Slab* next;
+    size_t bytes;
+  };
+
+  size_t node_size_;
+  size_t slab_nodes_ = kMinSlabNodes;
+  void* free_ = nullptr;
+  char* cursor_ = nullptr;
+  char* end_ = nullptr;
+  Slab* slabs_ = nullptr;
+
+  void add_slab();
+};
+
+inline NodePool::~NodePool() {
+  while (slabs_ != nullptr) {
+    Slab* next = slabs_->next;
+    ::operator delete(slabs_, slabs_->bytes,
+                      std::align_val_t(alignof(Slab)));
+    slabs_ = next;
+  }
+}
+
+inline void NodePool::add_slab() {
+  size_t bytes = sizeof(Slab) + slab_nodes_ * node_size_;
+  auto* slab = static_cast<Slab*>(
+      ::operator new(bytes, std::align_val_t(alignof(Slab))));
+  slab->next = slabs_;
+  slab->bytes = bytes;
+  slabs_ = slab;
+  cursor_ = reinterpret_cast<char*>(slab + 1);
+  end_ = cursor_ + slab_nodes_ * node_size_;
+  slab_nodes_ = std::min(slab_nodes_ * 2, kMaxSlabNodes);
+}
+
+// The pools shared by a family of NodePoolAllocators, one per node size.
+class NodePoolSet {
+ public:
+  NodePool& pool_for(size_t node_size) {
+    for (auto& pool : pools_) {
+      if (pool->node_size() == node_size) {
+        return *pool;
+      }
+    }
+    pools_.push_back(std::make_unique<NodePool>(node_size));
+    return *pools_.back();
+  }
+
+ private:
+  std::vector<std::unique_ptr<NodePool>> pools_;
+};
+
+// Allocator for node-based containers such as List: single-object
+// allocations come from a NodePool, so consecutive nodes sit next to each
+// other and a push/pop pair costs a couple of pointer moves instead of a
+// malloc/free. Array allocations and over-aligned types go to operator new.
+//
+// Copies and rebinds share one NodePoolSet and compare equal, and the
+// allocator propagates with the container. A copied container gets a pool
+// set of its own. Not thread-safe: a pool set belongs to one thread at a
+// time.
+template <typename T>
+class NodePoolAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  NodePoolAllocator() : NodePoolAllocator(std::make_shared<NodePoolSet>()) {}
+  // No move operations: a moved-from allocator must still compare equal to
+  // the moved-to one, so moving copies.
+  NodePoolAllocator(const NodePoolAllocator& alloc) = default;
+  NodePoolAllocator& operator=(const NodePoolAllocator& alloc) = default;
+  template <typename U>
+  NodePoolAllocator(const NodePoolAllocator<U>& alloc)
+      : NodePoolAllocator(alloc.pools_) {}
+
+  NodePoolAllocator select_on_container_copy_construction() const {
+    return NodePoolAllocator();
+  }
+
+  T* allocate(size_t count);
+  void deallocate(T* pointer, size_t count);
+
+  template <typename U>
+  bool operator==(const NodePoolAllocator<U>& alloc) const {
+    return pools_ == alloc.pools_;
+  }
+  template <typename U>
+  bool operator!=(const NodePoolAllocator<U>& alloc) const {
+    return pools_ != alloc.pools_;
+  }
+
+ private:
+  template <typename U>
+  friend class NodePoolAllocator;
+
+  // A node must be able to hold the free list link, and its size has to
+  // keep every node in a slab aligned.
+  static constexpr size_t kNodeSize =
+      (std::max(sizeof(T), sizeof(void*)) + alignof(void*) - 1) &
+      ~(alignof(void*) - 1);
+  static constexpr bool kPooled = alignof(T) <= alignof(std::max_align_t);
+
+  std::shared_ptr<NodePoolSet> pools_;
+  NodePool* pool_;
+
+  explicit NodePoolAllocator(std::shared_ptr<NodePoolSet> pools)
+      : pools_(std::move(pools)),
+        pool_(kPooled ? &pools_->pool_for(kNodeSize) : nullptr) {}
+};
+
+template <typename T>
+T* NodePoolAllocator<T>::allocate(size_t count) {
+  if (kPooled and count == 1) {
+    return static_cast<T*>(pool_->allocate());
+  }
+  return static_cast<T*>(
+      ::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+}
+
+template <typename T>
+void NodePoolAllocator<T>::deallocate(T* pointer, size_t count) {
+  if (kPooled and count == 1) {
+    pool_->deallocate(pointer);
+    return;
+  }
+  ::operator delete(pointer, count * sizeof(T), std::align_val_t(alignof(T)));
+}
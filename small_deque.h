@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "deque.h"
+#include "fixed_deque.h"
+
+// Deque that keeps up to N elements in an inline ring (a FixedDeque) and
+// only moves them into a block-map Deque when the ring overflows. An empty
+// or small SmallDeque never touches the allocator: the Deque member
+// allocates nothing until it receives its first element. Once the heap
+// deque drains, the inline ring takes over again; shrink_to_fit() moves
+// the elements back inline as soon as they fit.
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
+class SmallDeque {
+  static constexpr size_t round_up_to_power_of_two(size_t value) {
+    size_t power = 1;
+    while (power < value) {
+      power *= 2;
+    }
+    return power;
+  }
+
+  // The ring needs a power-of-two capacity, so up to kInline >= N elements
+  // are kept inline.
+  static constexpr size_t kInline = round_up_to_power_of_two(N);
+
+ public:
+  SmallDeque() = default;
+  SmallDeque(const Allocator& alloc) : heap_(alloc) {}
+  SmallDeque(const SmallDeque& deque) = default;
+  SmallDeque(SmallDeque&& deque) = default;
+  SmallDeque& operator=(const SmallDeque& deque) = default;
+  SmallDeque& operator=(SmallDeque&& deque) = default;
+
+  [[nodiscard]] size_t size() const {
+    return (is_inline() ? inline_.size() : heap_.size());
+  }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+  // True while the elements live in the inline ring.
+  [[nodiscard]] bool is_inline() const { return heap_.size() == 0; }
+
+  T& operator[](size_t index) {
+    return (is_inline() ? inline_[index] : heap_[index]);
+  }
+  const T& operator[](size_t index) const {
+    return (is_inline() ? inline_[index] : heap_[index]);
+  }
+  T& at(ssize_t index);
+  const T& at(ssize_t index) const;
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  void pop_back();
+  void pop_front();
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  template <typename... Args>
+  T& emplace_front(Args&&... args);
+
+  void clear();
+  // Moves the elements back inline if they fit, and releases the heap
+  // deque's memory.
+  void shrink_to_fit();
+
+  template <bool IsConst>
+  class common_iterator;
+
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  iterator begin() { return iterator(this, 0); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+  const_iterator end() const { return const_iterator(this, size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+  reverse_iterator rbegin() { return std::make_reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return std::make_reverse_iterator(cend());
+  }
+  reverse_iterator rend() { return std::make_reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return std::make_reverse_iterator(cbegin());
+  }
+
+ private:
+  // At most one of the two holds elements.
+  FixedDeque<T, kInline> inline_;
+  Deque<T, Allocator> heap_;
+
+  void spill();
+};
+
+template <typename T, size_t N, typename Allocator>
+template <bool IsConst>
+class SmallDeque<T, N, Allocator>::common_iterator {
+ public:
+  using Owner = std::conditional_t<IsConst, const SmallDeque, SmallDeque>;
+  using value_type = std::conditional_t<IsConst, const T, T>;
+  using difference_type = long long;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using iterator_category = std::random_access_iterator_tag;
+
+  common_iterator() = default;
+  common_iterator(Owner* owner, size_t index) : owner_(owner), index_(index) {}
+  operator const_iterator() const { return const_iterator(owner_, index_); }
+
+  reference operator*() const { return (*owner_)[index_]; }
+  pointer operator->() const { return &(*owner_)[index_]; }
+  reference operator[](difference_type number) const {
+    return (*owner_)[index_ + number];
+  }
+
+  common_iterator& operator+=(difference_type number) {
+    index_ += number;
+    return *this;
+  }
+  common_iterator& operator-=(difference_type number) {
+    index_ -= number;
+    return *this;
+  }
+  common_iterator operator+(difference_type number) const {
+    return common_iterator(owner_, index_ + number);
+  }
+  friend common_iterator operator+(difference_type number,
+                                   const common_iterator& iter) {
+    return iter + number;
+  }
+  common_iterator operator-(difference_type number) const {
+    return common_iterator(owner_, index_ - number);
+  }
+  common_iterator& operator++() {
+    ++index_;
+    return *this;
+  }
+  common_iterator operator++(int) {
+    auto iter = *this;
+    ++index_;
+    return iter;
+  }
+  common_iterator& operator--() {
+    --index_;
+    return *this;
+  }
+  common_iterator operator--(int) {
+    auto iter = *this;
+    --index_;
+    return iter;
+  }
+
+  difference_type operator-(const common_iterator& iter) const {
+    return static_cast<difference_type>(index_) -
+           static_cast<difference_type>(iter.index_);
+  }
+  bool operator<(const common_iterator& iter) const {
+    return index_ < iter.index_;
+  }
+  bool operator>(const common_iterator& iter) const { return iter < (*this); }
+  bool operator<=(const common_iterator& iter) const {
+    return !((*this) > iter);
+  }
+  bool operator>=(const common_iterator& iter) const {
+    return !((*this) < iter);
+  }
+  bool operator==(const common_iterator& iter) const {
+    return index_ == iter.index_;
+  }
+  bool operator!=(const common_iterator& iter) const {
+    return !((*this) == iter);
+  }
+
+ private:
+  Owner* owner_ = nullptr;
+  size_t index_ = 0;
+};
+
+template <typename T, size_t N, typename Allocator>
+T& SmallDeque<T, N, Allocator>::at(ssize_t index) {
+  if (index < 0 or index >= static_cast<ssize_t>(size())) {
+    throw std::out_of_range("");
+  }
+  return (*this)[index];
+}
+template <typename T, size_t N, typename Allocator>
+const T& SmallDeque<T, N, Allocator>::at(ssize_t index) const {
+  if (index < 0 or index >= static_cast<ssize_t>(size())) {
+    throw std::out_of_range("");
+  }
+  return (*this)[index];
+}
+
+template <typename T, size_t N, typename Allocator>
+void SmallDeque<T, N, Allocator>::spill() {
+  heap_.reserve_back(kInline + 1);
+  heap_.append_range(std::make_move_iterator(inline_.begin()),
+                     std::make_move_iterator(inline_.end()));
+  inline_.clear();
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename... Args>
+T& SmallDeque<T, N, Allocator>::emplace_back(Args&&... args) {
+  if (is_inline()) {
+    if (!inline_.full()) {
+      return inline_.emplace_back(std::forward<Args>(args)...);
+    }
+    // The arguments may refer to an inline element, so the new element is
+    // built before the ring is moved out.
+    T value(std::forward<Args>(args)...);
+    spill();
+    return heap_.emplace_back(std::move(value));
+  }
+  return heap_.emplace_back(std::forward<Args>(args)...);
+}
+template <typename T, size_t N, typename Allocator>
+template <typename... Args>
+T& SmallDeque<T, N, Allocator>::emplace_front(Args&&... args) {
+  if (is_inline()) {
+    if (!inline_.full()) {
+      return inline_.emplace_front(std::forward<Args>(args)...);
+    }
+    // The arguments may refer to an inline element, so the new element is
+    // built before the ring is moved out.
+    T value(std::forward<Args>(args)...);
+    spill();
+    return heap_.emplace_front(std::move(value));
+  }
+  return heap_.emplace_front(std::forward<Args>(args)...);
+}
+template <typename T, size_t N, typename Allocator>
+void SmallDeque<T, N, Allocator>::pop_back() {
+  if (is_inline()) {
+    inline_.pop_back();
+  } else {
+    heap_.pop_back();
+  }
+}
+template <typename T, size_t N, typename Allocator>
+void SmallDeque<T, N, Allocator>::pop_front() {
+  if (is_inline()) {
+    inline_.pop_front();
+  } else {
+    heap_.pop_front();
+  }
+}
+
+template <typename T, size_t N, typename Allocator>
+void SmallDeque<T, N, Allocator>::clear() {
+  inline_.clear();
+  heap_.clear();
+}
+template <typename T, size_t N, typename Allocator>
+void SmallDeque<T, N, Allocator>::shrink_to_fit() {
+  if (heap_.size() <= kInline) {
+    // Elements are copied unless their move cannot throw, so a failure
+    // leaves them all on the heap and the ring empty again.
+    try {
+      for (size_t i = 0; i < heap_.size(); i++) {
+        inline_.emplace_back(std::move_if_noexcept(heap_[i]));
+      }
+    } catch (...) {
+      inline_.clear();
+      throw;
+    }
+    heap_.clear();
+  }
+  heap_.shrink_to_fit();
+}
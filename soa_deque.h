@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "deque.h"
+
+// Structure-of-arrays deque of records (Fields...). Every block holds kBase
+// records as one aligned column segment per field, so a scan over one field
+// reads only that field's cache lines. Blocks are linked into a Deque of
+// block pointers, which gives the same double-ended, block-segmented growth
+// as Deque itself.
+//
+// Records are meant to be small PODs, so every field must be trivially
+// copyable and trivially destructible.
+template <typename... Fields>
+class SoADeque {
+  static_assert(sizeof...(Fields) > 0, "SoADeque needs at least one field");
+  static_assert((std::is_trivially_copyable_v<Fields> and ...) and
+                    (std::is_trivially_destructible_v<Fields> and ...),
+                "SoADeque fields must be trivially copyable");
+
+ public:
+  template <size_t K>
+  using Field = std::tuple_element_t<K, std::tuple<Fields...>>;
+
+  template <bool IsConst>
+  class RowRef;
+  template <bool IsConst>
+  class common_iterator;
+
+  using row_reference = RowRef<false>;
+  using const_row_reference = RowRef<true>;
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+
+  SoADeque() = default;
+  SoADeque(const SoADeque& deque);
+  SoADeque(SoADeque&& deque) noexcept;
+  SoADeque& operator=(const SoADeque& deque);
+  SoADeque& operator=(SoADeque&& deque) noexcept;
+  ~SoADeque();
+
+  void swap(SoADeque& deque) noexcept;
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  void push_back(const Fields&... values);
+  void push_front(const Fields&... values);
+  void pop_back();
+  void pop_front();
+  void clear();
+
+  // Field K of record `index`.
+  template <size_t K>
+  Field<K>& get(size_t index) {
+    size_t position = offset_ + index;
+    return column<K>(blocks_[block(position)])[position % kBase];
+  }
+  template <size_t K>
+  const Field<K>& get(size_t index) const {
+    size_t position = offset_ + index;
+    return column<K>(blocks_[block(position)])[position % kBase];
+  }
+
+  row_reference operator[](size_t index) {
+    return row_reference(this, offset_ + index);
+  }
+  const_row_reference operator[](size_t index) const {
+    return const_row_reference(this, offset_ + index);
+  }
+
+  iterator begin() { return iterator(this, offset_); }
+  const_iterator begin() const { return const_iterator(this, offset_); }
+  iterator end() { return iterator(this, offset_ + size_); }
+  const_iterator end() const { return const_iterator(this, offset_ + size_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // Hands column K to `visitor(first, last)` one contiguous block span at a
+  // time, front to back.
+  template <size_t K, typename Visitor>
+  void for_each_span(Visitor visitor);
+  template <size_t K, typename Visitor>
+  void for_each_span(Visitor visitor) const;
+
+ private:
+  static constexpr size_t kFields = sizeof...(Fields);
+  static constexpr size_t kRowBytes = (sizeof(Fields) + ...);
+  static constexpr size_t kBase =
+      std::max<size_t>(4096 / kRowBytes, 16) / 16 * 16;
+  static constexpr size_t kAlignment =
+      std::max({size_t{64}, alignof(Fields)...});
+
+  // Byte offset of every column segment inside a block, each rounded up to
+  // kAlignment so that columns never share a cache line.
+  static constexpr std::array<size_t, kFields + 1> kOffsets = [] {
+    std::array<size_t, kFields + 1> offsets{};
+    size_t sizes[] = {sizeof(Fields)...};
+    for (size_t i = 0; i < kFields; i++) {
+      size_t end = offsets[i] + sizes[i] * kBase;
+      offsets[i + 1] = (end + kAlignment - 1) / kAlignment * kAlignment;
+    }
+    return offsets;
+  }();
+  static constexpr size_t kBlockBytes = kOffsets[kFields];
+
+  struct alignas(kAlignment) BlockChunk {
+    unsigned char bytes[kAlignment];
+  };
+  static constexpr size_t kBlockChunks = kBlockBytes / kAlignment;
+
+  // Records live at positions [offset_, offset_ + size_) of the blocks in
+  // blocks_. One drained block is kept back so that a deque used as a queue
+  // does not allocate on every block boundary.
+  Deque<unsigned char*> blocks_;
+  unsigned char* spare_block_{nullptr};
+  size_t offset_{0};
+  size_t size_{0};
+
+  static size_t block(size_t position) { return position / kBase; }
+
+  template <size_t K>
+  static Field<K>* column(unsigned char* block_ptr) {
+    return std::launder(
+        reinterpret_cast<Field<K>*>(block_ptr + std::get<K>(kOffsets)));
+  }
+
+  unsigned char* acquire_block() {
+    if (spare_block_ != nullptr) {
+      return std::exchange(spare_block_, nullptr);
+    }
+    std::allocator<BlockChunk> alloc;
+    return reinterpret_cast<unsigned char*>(alloc.allocate(kBlockChunks));
+  }
+  void release_block(unsigned char* block_ptr) {
+    if (spare_block_ == nullptr) {
+      spare_block_ = block_ptr;
+      return;
+    }
+    std::allocator<BlockChunk> alloc;
+    alloc.deallocate(reinterpret_cast<BlockChunk*>(block_ptr), kBlockChunks);
+  }
+
+  template <size_t... K>
+  void store(size_t position, std::index_sequence<K...>,
+             const Fields&... values) {
+    unsigned char* block_ptr = blocks_[block(position)];
+    ((column<K>(block_ptr)[position % kBase] = values), ...);
+  }
+};
+
+// Proxy for one record: get<K>() returns a reference to field K.
+template <typename... Fields>
+template <bool IsConst>
+class SoADeque<Fields...>::RowRef {
+ public:
+  using Owner = std::conditional_t<IsConst, const SoADeque, SoADeque>;
+
+  RowRef(Owner* owner, size_t position) : owner_(owner), position_(position) {}
+
+  template <size_t K>
+  std::conditional_t<IsConst, const Field<K>&, Field<K>&> get() const {
+    return column<K>(owner_->blocks_[block(position_)])[position_ % kBase];
+  }
+
+  operator std::tuple<Fields...>() const {
+    return to_tuple(std::index_sequence_for<Fields...>());
+  }
+
+ private:
+  Owner* owner_;
+  size_t position_;
+
+  template <size_t... K>
+  std::tuple<Fields...> to_tuple(std::index_sequence<K...>) const {
+    return std::tuple<Fields...>(get<K>()...);
+  }
+};
+
+// Random-access iterator over records; dereferencing yields a RowRef.
+template <typename... Fields>
+template <bool IsConst>
+class SoADeque<Fields...>::common_iterator {
+ public:
+  using Owner = std::conditional_t<IsConst, const SoADeque, SoADeque>;
+  using value_type = std::tuple<Fields...>;
+  using difference_type = long long;
+  using reference = RowRef<IsConst>;
+  using pointer = void;
+  using iterator_category = std::random_access_iterator_tag;
+
+  common_iterator() = default;
+  common_iterator(Owner* owner, size_t position)
+      : owner_(owner), position_(position) {}
+  operator const_iterator() const { return const_iterator(owner_, position_); }
+
+  reference operator*() const { return reference(owner_, position_); }
+  reference operator[](difference_type number) const {
+    return reference(owner_, position_ + number);
+  }
+
+  common_iterator& operator+=(difference_type number) {
+    position_ += number;
+    return *this;
+  }
+  common_iterator& operator-=(difference_type number) {
+    position_ -= number;
+    return *this;
+  }
+  common_iterator operator+(difference_type number) const {
+    return common_iterator(owner_, position_ + number);
+  }
+  common_iterator operator-(difference_type number) const {
+    return common_iterator(owner_, position_ - number);
+  }
+  common_iterator& operator++() {
+    ++position_;
+    return *this;
+  }
+  common_iterator operator++(int) {
+    auto iter = *this;
+    ++position_;
+    return iter;
+  }
+  common_iterator& operator--() {
+    --position_;
+    return *this;
+  }
+  common_iterator operator--(int) {
+    auto iter = *this;
+    --position_;
+    return iter;
+  }
+
+  difference_type operator-(const common_iterator& iter) const {
+    return static_cast<difference_type>(position_) -
+           static_cast<difference_type>(iter.position_);
+  }
+  bool operator<(const common_iterator& iter) const {
+    return position_ < iter.position_;
+  }
+  bool operator>(const common_iterator& iter) const { return iter < (*this); }
+  bool operator<=(const common_iterator& iter) const {
+    return !((*this) > iter);
+  }
+  bool operator>=(const common_iterator& iter) const {
+    return !((*this) < iter);
+  }
+  bool operator==(const common_iterator& iter) const {
+    return position_ == iter.position_;
+  }
+  bool operator!=(const common_iterator& iter) const {
+    return !((*this) == iter);
+  }
+
+ private:
+  Owner* owner_ = nullptr;
+  size_t position_ = 0;
+};
+
+template <typename... Fields>
+SoADeque<Fields...>::SoADeque(const SoADeque& deque) {
+  for (size_t i = 0; i < deque.size_; i++) {
+    std::apply([this](const Fields&... values) { push_back(values...); },
+               std::tuple<Fields...>(deque[i]));
+  }
+}
+template <typename... Fields>
+SoADeque<Fields...>::SoADeque(SoADeque&& deque) noexcept {
+  swap(deque);
+}
+template <typename... Fields>
+SoADeque<Fields...>& SoADeque<Fields...>::operator=(const SoADeque& deque) {
+  if (this != &deque) {
+    SoADeque temporary(deque);
+    swap(temporary);
+  }
+  return *this;
+}
+template <typename... Fields>
+SoADeque<Fields...>& SoADeque<Fields...>::operator=(
+    SoADeque&& deque) noexcept {
+  SoADeque temporary(std::move(deque));
+  swap(temporary);
+  return *this;
+}
+template <typename... Fields>
+SoADeque<Fields...>::~SoADeque() {
+  clear();
+  if (spare_block_ != nullptr) {
+    std::allocator<BlockChunk> alloc;
+    alloc.deallocate(reinterpret_cast<BlockChunk*>(spare_block_),
+                     kBlockChunks);
+  }
+}
+
+template <typename... Fields>
+void SoADeque<Fields...>::swap(SoADeque& deque) noexcept {
+  blocks_.swap(deque.blocks_);
+  std::swap(spare_block_, deque.spare_block_);
+  std::swap(offset_, deque.offset_);
+  std::swap(size_, deque.size_);
+}
+
+template <typename... Fields>
+void SoADeque<Fields...>::push_back(const Fields&... values) {
+  size_t position = offset_ + size_;
+  if (block(position) == blocks_.size()) {
+    unsigned char* block_ptr = acquire_block();
+    try {
+      blocks_.push_back(block_ptr);
+    } catch (...) {
+      release_block(block_ptr);
+      throw;
+    }
+  }
+  store(position, std::index_sequence_for<Fields...>(), values...);
+  size_++;
+}
+template <typename... Fields>
+void SoADeque<Fields...>::push_front(const Fields&... values) {
+  if (offset_ == 0) {
+    unsigned char* block_ptr = acquire_block();
+    try {
+      blocks_.push_front(block_ptr);
+    } catch (...) {
+      release_block(block_ptr);
+      throw;
+    }
+    offset_ = kBase;
+  }
+  offset_--;
+  store(offset_, std::index_sequence_for<Fields...>(), values...);
+  size_++;
+}
+template <typename... Fields>
+void SoADeque<Fields...>::pop_back() {
+  size_--;
+  if ((offset_ + size_) % kBase == 0 or size_ == 0) {
+    release_block(blocks_[blocks_.size() - 1]);
+    blocks_.pop_back();
+    if (size_ == 0) {
+      offset_ = 0;
+    }
+  }
+}
+template <typename... Fields>
+void SoADeque<Fields...>::pop_front() {
+  offset_++;
+  size_--;
+  if (offset_ == kBase or size_ == 0) {
+    release_block(blocks_[0]);
+    blocks_.pop_front();
+    offset_ = (size_ == 0 ? 0 : offset_ - kBase);
+  }
+}
+template <typename... Fields>
+void SoADeque<Fields...>::clear() {
+  while (blocks_.size() > 0) {
+    release_block(blocks_[blocks_.size() - 1]);
+    blocks_.pop_back();
+  }
+  offset_ = 0;
+  size_ = 0;
+}
+
+template <typename... Fields>
+template <size_t K, typename Visitor>
+void SoADeque<Fields...>::for_each_span(Visitor visitor) {
+  size_t position = offset_;
+  size_t end = offset_ + size_;
+  while (position < end) {
+    size_t last = std::min(end, (block(position) + 1) * kBase);
+    Field<K>* data = column<K>(blocks_[block(position)]);
+    visitor(data + position % kBase, data + (last - 1) % kBase + 1);
+    position = last;
+  }
+}
+template <typename... Fields>
+template <size_t K, typename Visitor>
+void SoADeque<Fields...>::for_each_span(Visitor visitor) const {
+  const_cast<SoADeque*>(this)->template for_each_span<K>(
+      [&visitor](Field<K>* first, Field<K>* last) {
+        visitor(static_cast<const Field<K>*>(first),
+                static_cast<const Field<K>*>(last));
+      });
+}
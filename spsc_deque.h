@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "deque.h"
+
+// Unbounded single-producer/single-consumer queue with Deque's block layout.
+// The producer appends elements to a chain of blocks and links a fresh block
+// when the last one fills up; the consumer pops from the front and hands each
+// drained block back to the producer through a recycle stack. The only shared
+// state is the pushed/popped element counters (release stores, acquire
+// loads) and the recycle stack head, so neither side ever takes a lock or
+// waits for the other.
+//
+// push_back/emplace_back may only be called from one thread at a time, and
+// try_pop_front from one (other) thread at a time.
+template <typename T, typename Allocator = std::allocator<T>,
+          typename BlockPolicy = DequeBlockPolicy<>>
+class SpscDeque {
+ public:
+  using AllocTraits = std::allocator_traits<Allocator>;
+
+  static_assert(std::is_same_v<typename AllocTraits::value_type, T>,
+                "SpscDeque must have the same value_type as its allocator");
+
+  SpscDeque();
+  SpscDeque(const Allocator& alloc);
+  SpscDeque(const SpscDeque&) = delete;
+  SpscDeque& operator=(const SpscDeque&) = delete;
+  ~SpscDeque();
+
+  // Producer side.
+  void push_back(const T& value);
+  void push_back(T&& value);
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
+  // Consumer side: moves the front element into `value` and pops it, or
+  // returns false if the queue is empty.
+  bool try_pop_front(T& value);
+
+  // Exact when called from either side while the other one is idle, a
+  // snapshot otherwise.
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] bool empty() const;
+
+ private:
+  static constexpr size_t kBase = BlockPolicy::template kElements<T>;
+  static constexpr size_t kCacheLine = 64;
+
+  struct alignas(BlockPolicy::template kAlignment<T>) Block {
+    Block* next;
+    alignas(T) unsigned char storage[kBase * sizeof(T)];
+
+    T* data() { return reinterpret_cast<T*>(storage); }
+  };
+
+  using BlockAlloc = typename AllocTraits::template rebind_alloc<Block>;
+  using BlockTraits = std::allocator_traits<BlockAlloc>;
+
+  Allocator alloc_;
+
+  // Written by the producer only.
+  alignas(kCacheLine) std::atomic<size_t> pushed_{0};
+  Block* tail_block_;
+  size_t tail_index_{0};
+  Block* free_blocks_{nullptr};
+
+  // Written by the consumer only.
+  alignas(kCacheLine) std::atomic<size_t> popped_{0};
+  Block* head_block_;
+  size_t head_index_{0};
+  size_t known_pushed_{0};
+
+  // Drained blocks on their way back from the consumer to the producer.
+  alignas(kCacheLine) std::atomic<Block*> recycled_{nullptr};
+
+  Block* allocate_block() {
+    BlockAlloc block_alloc(alloc_);
+    Block* block = BlockTraits::allocate(block_alloc, 1);
+    block->next = nullptr;
+    return block;
+  }
+  void deallocate_chain(Block* block) {
+    BlockAlloc block_alloc(alloc_);
+    while (block != nullptr) {
+      Block* next = block->next;
+      BlockTraits::deallocate(block_alloc, block, 1);
+      block = next;
+    }
+  }
+
+  // Producer: a block for the next element, reusing drained ones first.
+  Block* acquire_block() {
+    if (free_blocks_ == nullptr) {
+      free_blocks_ = recycled_.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (free_blocks_ == nullptr) {
+      return allocate_block();
+    }
+    Block* block = free_blocks_;
+    free_blocks_ = block->next;
+    block->next = nullptr;
+    return block;
+  }
+  // Consumer: hands a drained block back to the producer.
+  void recycle_block(Block* block) {
+    Block* top = recycled_.load(std::memory_order_relaxed);
+    do {
+      block->next = top;
+    } while (!recycled_.compare_exchange_weak(top, block,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+  }
+};
+
+template <typename T, typename Allocator, typename BlockPolicy>
+SpscDeque<T, Allocator, BlockPolicy>::SpscDeque()
+    : SpscDeque(Allocator()) {}
+template <typename T, typename Allocator, typename BlockPolicy>
+SpscDeque<T, Allocator, BlockPolicy>::SpscDeque(const Allocator& alloc)
+    : alloc_(alloc) {
+  tail_block_ = allocate_block();
+  head_block_ = tail_block_;
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+SpscDeque<T, Allocator, BlockPolicy>::~SpscDeque() {
+  size_t count = pushed_.load(std::memory_order_acquire) -
+                 popped_.load(std::memory_order_acquire);
+  Block* block = head_block_;
+  size_t index = head_index_;
+  for (; count > 0; count--) {
+    if (index == kBase) {
+      block = block->next;
+      index = 0;
+    }
+    AllocTraits::destroy(alloc_, block->data() + index++);
+  }
+  deallocate_chain(head_block_);
+  deallocate_chain(free_blocks_);
+  deallocate_chain(recycled_.load(std::memory_order_acquire));
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void SpscDeque<T, Allocator, BlockPolicy>::push_back(const T& value) {
+  emplace_back(value);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+void SpscDeque<T, Allocator, BlockPolicy>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+template <typename... Args>
+void SpscDeque<T, Allocator, BlockPolicy>::emplace_back(Args&&... args) {
+  if (tail_index_ == kBase) {
+    // The link is published together with the first element of the new
+    // block by the release store below.
+    tail_block_->next = acquire_block();
+    tail_block_ = tail_block_->next;
+    tail_index_ = 0;
+  }
+  AllocTraits::construct(alloc_, tail_block_->data() + tail_index_,
+                         std::forward<Args>(args)...);
+  tail_index_++;
+  pushed_.store(pushed_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+bool SpscDeque<T, Allocator, BlockPolicy>::try_pop_front(T& value) {
+  size_t popped = popped_.load(std::memory_order_relaxed);
+  if (popped == known_pushed_) {
+    known_pushed_ = pushed_.load(std::memory_order_acquire);
+    if (popped == known_pushed_) {
+      return false;
+    }
+  }
+  if (head_index_ == kBase) {
+    Block* drained = head_block_;
+    head_block_ = drained->next;
+    head_index_ = 0;
+    recycle_block(drained);
+  }
+  T* element = head_block_->data() + head_index_;
+  value = std::move(*element);
+  AllocTraits::destroy(alloc_, element);
+  head_index_++;
+  popped_.store(popped + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t SpscDeque<T, Allocator, BlockPolicy>::size() const {
+  size_t popped = popped_.load(std::memory_order_acquire);
+  size_t pushed = pushed_.load(std::memory_order_acquire);
+  return (pushed > popped ? pushed - popped : 0);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+bool SpscDeque<T, Allocator, BlockPolicy>::empty() const {
+  return size() == 0;
+}
@@ -1,6 +1,20 @@
 // NOLINTBEGIN
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <type_traits>
 
 template <typename T, typename Allocator = std::allocator<T>>
 class List {
@@ -12,12 +26,14 @@ class List {
 
     Node() = default;
 
-    Node(const T& value) : value(value) {}
+    template <typename... Args>
+    Node(Args&&... args) : value(std::forward<Args>(args)...) {}
   };
 
-  BaseNode fakeNode_;
-  Node* head_ = static_cast<Node*>(&fakeNode_);
-  Node* tail_ = static_cast<Node*>(&fakeNode_);
+  // The list is circular through this sentinel: fakeNode_.next is the first
+  // node, fakeNode_.prev the last one, and an empty list links it to itself.
+  // end() points at it, so it stays valid whatever happens to the elements.
+  BaseNode fakeNode_{&fakeNode_, &fakeNode_};
   size_t size_ = 0;
 
   using NodeAlloc =
@@ -26,49 +42,86 @@ class List {
 
   NodeAlloc alloc_;
 
-  void add_node_to_end(Node* new_node) {
-    new_node->prev = tail_->prev;
-    new_node->next = tail_;
-    if (tail_->prev != nullptr) {
-      tail_->prev->next = new_node;
-    } else {
-      head_ = new_node;
-    }
+  static Node* as_node(BaseNode* node) { return static_cast<Node*>(node); }
+  BaseNode* sentinel() const { return const_cast<BaseNode*>(&fakeNode_); }
 
-    tail_->prev = new_node;
+  void add_node_to_end(Node* new_node) {
+    link_nodes(&fakeNode_, new_node, new_node);
     size_++;
   }
 
   void add_node_to_start(Node* new_node) {
-    new_node->next = head_;
-    head_->prev = new_node;
-    head_ = new_node;
-
+    link_nodes(fakeNode_.next, new_node, new_node);
     size_++;
   }
 
+  // Takes over the nodes of `list`, which must not share them with this
+  // one, and leaves `list` empty.
+  void steal_nodes(List<T, Allocator>& list) {
+    if (list.size_ == 0) {
+      fakeNode_.next = fakeNode_.prev = &fakeNode_;
+    } else {
+      fakeNode_ = list.fakeNode_;
+      fakeNode_.next->prev = &fakeNode_;
+      fakeNode_.prev->next = &fakeNode_;
+    }
+    size_ = list.size_;
+    list.fakeNode_.next = list.fakeNode_.prev = &list.fakeNode_;
+    list.size_ = 0;
+  }
+
   void swap_lists(List<T, Allocator>& list) {
-    std::swap(list.fakeNode_, fakeNode_);
-    std::swap(list.size_, size_);
-    std::swap(list.head_, head_);
-    std::swap(list.tail_, tail_);
+    BaseNode* first = fakeNode_.next;
+    BaseNode* last = fakeNode_.prev;
+    size_t size = size_;
+    steal_nodes(list);
+    if (size != 0) {
+      list.fakeNode_.next = first;
+      list.fakeNode_.prev = last;
+      first->prev = &list.fakeNode_;
+      last->next = &list.fakeNode_;
+    }
+    list.size_ = size;
     std::swap(list.alloc_, alloc_);
   }
 
+  template <typename... Args>
+  Node* create_node(Args&&... args) {
+    Node* new_node(AllocTraits::allocate(alloc_, 1));
+    try {
+      AllocTraits::construct(alloc_, new_node, std::forward<Args>(args)...);
+    } catch (...) {
+      AllocTraits::deallocate(alloc_, new_node, 1);
+      throw;
+    }
+    return new_node;
+  }
+
  public:
   List() = default;
   List(size_t size, const Allocator& alloc = Allocator());
   List(size_t size, const T& value, const Allocator& alloc = Allocator());
   List(const Allocator& alloc);
   List(const List<T, Allocator>& list);
+  List(List<T, Allocator>&& list) noexcept;
   List& operator=(const List& list);
+  List& operator=(List&& list) noexcept(
+      AllocTraits::propagate_on_container_move_assignment::value ||
+      AllocTraits::is_always_equal::value);
   ~List();
 
   void push_back(const T& value);
+  void push_back(T&& value);
   void push_front(const T& value);
+  void push_front(T&& value);
   void pop_back();
   void pop_front();
 
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  template <typename... Args>
+  T& emplace_front(Args&&... args);
+
   [[nodiscard]] size_t size() const { return size_; }
 
   NodeAlloc get_allocator() const { return alloc_; }
@@ -81,13 +134,13 @@ class List {
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-  iterator begin() { return iterator(head_, 0); }
+  iterator begin() { return iterator(fakeNode_.next); }
 
-  iterator end() { return iterator(tail_, size_); }
+  iterator end() { return iterator(&fakeNode_); }
 
-  const_iterator begin() const { return const_iterator(head_, 0); }
+  const_iterator begin() const { return const_iterator(fakeNode_.next); }
 
-  const_iterator end() const { return const_iterator(tail_, size_); }
+  const_iterator end() const { return const_iterator(sentinel()); }
 
   const_iterator cbegin() const { return begin(); }
 
@@ -113,33 +166,78 @@ class List {
     return std::make_reverse_iterator(cbegin());
   }
 
-  void insert(const_iterator it, const T& element);
+  iterator insert(const_iterator it, const T& element);
+  iterator insert(const_iterator it, T&& element);
+  template <typename... Args>
+  iterator emplace(const_iterator it, Args&&... args);
 
   void add_node_to_pos(const_iterator it, Node* new_node) {
-    if (it->prev == nullptr) {
-      head_->prev = new_node;
-      new_node->next = head_;
-      head_ = new_node;
-      if (size_ == 0) {
-        head_->next = nullptr;
-      }
-    } else {
-      it->prev->next = new_node;
-      new_node->prev = it->prev;
-      new_node->next = it.get_node();
-    }
-    it->prev = new_node;
-
+    link_nodes(it.get_node(), new_node, new_node);
     size_++;
   }
 
-  void erase(const_iterator it);
+  // Returns the iterator following the erased element; other iterators
+  // stay valid, so elements can be erased while iterating.
+  iterator erase(const_iterator it);
+
+  // The operations below relink nodes and never allocate or copy a T, as
+  // long as the lists' allocators compare equal. Otherwise the elements of
+  // `list` are moved into nodes from this list's allocator.
+  void splice(const_iterator it, List& list);
+  void splice(const_iterator it, List&& list) { splice(it, list); }
+  void splice(const_iterator it, List& list, const_iterator element);
+  void splice(const_iterator it, List&& list, const_iterator element) {
+    splice(it, list, element);
+  }
+  void splice(const_iterator it, List& list, const_iterator first,
+              const_iterator last);
+  void splice(const_iterator it, List&& list, const_iterator first,
+              const_iterator last) {
+    splice(it, list, first, last);
+  }
+
+  // Both lists must be sorted; the merge is stable.
+  void merge(List& list) { merge(list, std::less<>()); }
+  void merge(List&& list) { merge(list, std::less<>()); }
+  template <typename Compare>
+  void merge(List& list, Compare compare);
+  template <typename Compare>
+  void merge(List&& list, Compare compare) {
+    merge(list, std::move(compare));
+  }
+
+  size_t remove(const T& value) {
+    return remove_if([&value](const T& element) { return element == value; });
+  }
+  template <typename Predicate>
+  size_t remove_if(Predicate predicate);
+  size_t unique() { return unique(std::equal_to<>()); }
+  template <typename BinaryPredicate>
+  size_t unique(BinaryPredicate predicate);
+
+  void reverse();
+
+  // Stable bottom-up merge sort.
+  void sort() { sort(std::less<>()); }
+  template <typename Compare>
+  void sort(Compare compare);
+
+ private:
+  // Unlinks [first, last] (last included) without touching size_.
+  static void unlink_nodes(BaseNode* first, BaseNode* last);
+  // Links the chain [first, last] in front of `position`.
+  static void link_nodes(BaseNode* position, BaseNode* first, BaseNode* last);
+  // Destroys a chain of unlinked nodes joined through `next`.
+  void destroy_nodes(BaseNode* node);
+  template <typename Compare>
+  static BaseNode* merge_chains(BaseNode* first, BaseNode* second,
+                                Compare& compare);
 };
 
 template <typename T, typename Allocator>
 struct List<T, Allocator>::BaseNode {
-  Node* next = nullptr;
-  Node* prev = nullptr;
+  BaseNode* next = nullptr;
+  BaseNode* prev = nullptr;
 };
 
 template <typename T, typename Allocator>
@@ -185,18 +283,48 @@ List<T, Allocator>::List(const List<T, Allocator>& list)
   }
 }
 
+template <typename T, typename Allocator>
+List<T, Allocator>::List(List<T, Allocator>&& list) noexcept
+    : alloc_(std::move(list.alloc_)) {
+  steal_nodes(list);
+}
+
 template <typename T, typename Alloc>
 List<T, Alloc>& List<T, Alloc>::operator=(const List<T, Alloc>& list) {
-  List temporary(list);
-
-  if (AllocTraits::propagate_on_container_copy_assignment::value) {
-    temporary.alloc_ = list.alloc_;
+  // The copy is built with the allocator this list ends up with, so that
+  // its nodes are never released through a different allocator.
+  List temporary(AllocTraits::propagate_on_container_copy_assignment::value
+                     ? list.alloc_
+                     : alloc_);
+  for (auto& value : list) {
+    temporary.push_back(value);
   }
 
   swap_lists(temporary);
   return *this;
 }
 
+template <typename T, typename Alloc>
+List<T, Alloc>& List<T, Alloc>::operator=(List<T, Alloc>&& list) noexcept(
+    AllocTraits::propagate_on_container_move_assignment::value ||
+    AllocTraits::is_always_equal::value) {
+  if (AllocTraits::propagate_on_container_move_assignment::value ||
+      alloc_ == list.alloc_) {
+    List temporary(std::move(list));
+    if (!AllocTraits::propagate_on_container_move_assignment::value) {
+      temporary.alloc_ = alloc_;
+    }
+    swap_lists(temporary);
+  } else {
+    List temporary(alloc_);
+    for (auto& value : list) {
+      temporary.push_back(std::move(value));
+    }
+    swap_lists(temporary);
+  }
+  return *this;
+}
+
 template <typename T, typename Allocator>
 List<T, Allocator>::~List() {
   while (size_ != 0) {
@@ -206,59 +334,48 @@ List<T, Allocator>::~List() {
 
 template <typename T, typename Allocator>
 void List<T, Allocator>::push_back(const T& value) {
-  size_t size = size_;
-  Node* new_node(AllocTraits::allocate(alloc_, 1));
-  try {
-    AllocTraits::construct(alloc_, new_node, value);
-    add_node_to_end(new_node);
-  } catch (...) {
-    AllocTraits::deallocate(alloc_, new_node, 1);
-    size_ = size;
-    throw;
-  }
+  emplace_back(value);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::push_back(T&& value) {
+  emplace_back(std::move(value));
 }
 
 template <typename T, typename Allocator>
 void List<T, Allocator>::push_front(const T& value) {
-  size_t size = size_;
-  Node* new_node(AllocTraits::allocate(alloc_, 1));
-  try {
-    AllocTraits::construct(alloc_, new_node, value);
-    add_node_to_start(new_node);
-  } catch (...) {
-    AllocTraits::deallocate(alloc_, new_node, 1);
-    size_ = size;
-    throw;
-  }
+  emplace_front(value);
 }
 
 template <typename T, typename Allocator>
-void List<T, Allocator>::pop_back() {
-  if (size_ == 1) {
-    tail_->prev = nullptr;
-    AllocTraits::destroy(alloc_, head_);
-    AllocTraits::deallocate(alloc_, head_, 1);
-    head_ = tail_;
-  } else {
-    Node* tail = (tail_->prev)->prev;
-    AllocTraits::destroy(alloc_, tail_->prev);
-    AllocTraits::deallocate(alloc_, tail_->prev, 1);
-    tail->next = tail_;
-    tail_->prev = tail;
-  }
+void List<T, Allocator>::push_front(T&& value) {
+  emplace_front(std::move(value));
+}
 
-  size_--;
+template <typename T, typename Allocator>
+template <typename... Args>
+T& List<T, Allocator>::emplace_back(Args&&... args) {
+  Node* new_node = create_node(std::forward<Args>(args)...);
+  add_node_to_end(new_node);
+  return new_node->value;
 }
 
 template <typename T, typename Allocator>
-void List<T, Allocator>::pop_front() {
-  Node* head = head_->next;
-  AllocTraits::destroy(alloc_, head_);
-  AllocTraits::deallocate(alloc_, head_, 1);
-  head_ = head;
-  head_->prev = nullptr;
+template <typename... Args>
+T& List<T, Allocator>::emplace_front(Args&&... args) {
+  Node* new_node = create_node(std::forward<Args>(args)...);
+  add_node_to_start(new_node);
+  return new_node->value;
+}
 
-  size_--;
+template <typename T, typename Allocator>
+void List<T, Allocator>::pop_back() {
+  erase(const_iterator(fakeNode_.prev));
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::pop_front() {
+  erase(const_iterator(fakeNode_.next));
 }
 
 template <typename T, typename Allocator>
@@ -271,18 +388,18 @@ class List<T, Allocator>::common_iterator {
   using iterator_category = std::bidirectional_iterator_tag;
   using difference_type = long long;
 
-  common_iterator(Node* node, long long index) : node_(node), index_(index) {}
+  common_iterator() = default;
+  explicit common_iterator(BaseNode* node) : node_(node) {}
 
-  operator const_iterator() const { return const_iterator(node_, index_); }
+  operator const_iterator() const { return const_iterator(node_); }
 
-  reference operator*() { return node_->value; }
+  reference operator*() const { return as_node(node_)->value; }
 
-  Node* operator->() { return node_; }
+  pointer operator->() const { return &as_node(node_)->value; }
 
-  Node* get_node() { return node_; }
+  BaseNode* get_node() const { return node_; }
 
   common_iterator& operator++() {
-    index_ += 1;
     node_ = node_->next;
     return *this;
   }
@@ -294,7 +411,6 @@ class List<T, Allocator>::common_iterator {
   }
 
   common_iterator& operator--() {
-    index_ -= 1;
     node_ = node_->prev;
     return *this;
   }
@@ -306,109 +422,737 @@ class List<T, Allocator>::common_iterator {
   }
 
   bool operator==(const common_iterator& it) const {
-    return (index_ == it.index_);
+    return (node_ == it.node_);
   }
 
   bool operator!=(const common_iterator& it) const { return !((*this) == it); }
 
  private:
-  Node* node_;
-  long long index_ = 0;
+  BaseNode* node_ = nullptr;
 };
 
 template <typename T, typename Allocator>
-void List<T, Allocator>::insert(const_iterator it, const T& element) {
-  size_t size = size_;
-  try {
-    Node* new_node(AllocTraits::allocate(alloc_, 1));
-    AllocTraits::construct(alloc_, new_node, element);
-    add_node_to_pos(it, new_node);
-  } catch (...) {
-    size_ = size;
+typename List<T, Allocator>::iterator List<T, Allocator>::insert(
+    const_iterator it, const T& element) {
+  return emplace(it, element);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::insert(
+    const_iterator it, T&& element) {
+  return emplace(it, std::move(element));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+typename List<T, Allocator>::iterator List<T, Allocator>::emplace(
+    const_iterator it, Args&&... args) {
+  Node* new_node = create_node(std::forward<Args>(args)...);
+  add_node_to_pos(it, new_node);
+  return iterator(new_node);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::erase(
+    const_iterator it) {
+  BaseNode* node = it.get_node();
+  BaseNode* next = node->next;
+  unlink_nodes(node, node);
+
+  AllocTraits::destroy(alloc_, as_node(node));
+  AllocTraits::deallocate(alloc_, as_node(node), 1);
+
+  size_--;
+  return iterator(next);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::unlink_nodes(BaseNode* first, BaseNode* last) {
+  first->prev->next = last->next;
+  last->next->prev = first->prev;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::link_nodes(BaseNode* position, BaseNode* first,
+                                    BaseNode* last) {
+  first->prev = position->prev;
+  position->prev->next = first;
+  last->next = position;
+  position->prev = last;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::destroy_nodes(BaseNode* node) {
+  while (node != nullptr) {
+    BaseNode* next = node->next;
+    AllocTraits::destroy(alloc_, as_node(node));
+    AllocTraits::deallocate(alloc_, as_node(node), 1);
+    node = next;
   }
 }
 
 template <typename T, typename Allocator>
-void List<T, Allocator>::erase(const_iterator it) {
-  if (it->prev == nullptr) {
-    it->next->prev = nullptr;
-    head_ = it->next;
-  } else {
-    it->prev->next = it->next;
-    it->next->prev = it->prev;
+void List<T, Allocator>::splice(const_iterator it, List& list) {
+  if (&list == this or list.size_ == 0) {
+    return;
   }
+  if (!(alloc_ == list.alloc_)) {
+    splice(it, list, list.begin(), list.end());
+    return;
+  }
+  BaseNode* first = list.fakeNode_.next;
+  BaseNode* last = list.fakeNode_.prev;
+  list.fakeNode_.next = list.fakeNode_.prev = &list.fakeNode_;
+  link_nodes(it.get_node(), first, last);
+  size_ += list.size_;
+  list.size_ = 0;
+}
 
-  AllocTraits::destroy(alloc_, it.get_node());
-  AllocTraits::deallocate(alloc_, it.get_node(), 1);
+template <typename T, typename Allocator>
+void List<T, Allocator>::splice(const_iterator it, List& list,
+                                const_iterator element) {
+  const_iterator next = element;
+  splice(it, list, element, ++next);
+}
 
-  size_--;
+template <typename T, typename Allocator>
+void List<T, Allocator>::splice(const_iterator it, List& list,
+                                const_iterator first, const_iterator last) {
+  BaseNode* position = it.get_node();
+  BaseNode* begin = first.get_node();
+  BaseNode* end = last.get_node();
+  if (begin == end or begin == position) {
+    return;
+  }
+  if (!(alloc_ == list.alloc_)) {
+    while (begin != end) {
+      BaseNode* next = begin->next;
+      Node* node = create_node(std::move(as_node(begin)->value));
+      link_nodes(position, node, node);
+      size_++;
+      list.erase(const_iterator(begin));
+      begin = next;
+    }
+    return;
+  }
+  size_t count = 0;
+  BaseNode* back = begin;
+  for (; back->next != end; back = back->next) {
+    count++;
+  }
+  count++;
+  list.unlink_nodes(begin, back);
+  link_nodes(position, begin, back);
+  if (&list != this) {
+    list.size_ -= count;
+    size_ += count;
+  }
 }
 
-template <size_t N>
+template <typename T, typename Allocator>
+template <typename Compare>
+void List<T, Allocator>::merge(List& list, Compare compare) {
+  if (&list == this or list.size_ == 0) {
+    return;
+  }
+  if (!(alloc_ == list.alloc_)) {
+    List moved(alloc_);
+    moved.splice(moved.end(), list);
+    merge(moved, std::move(compare));
+    return;
+  }
+  BaseNode* position = fakeNode_.next;
+  while (list.size_ != 0) {
+    BaseNode* node = list.fakeNode_.next;
+    while (position != &fakeNode_ and
+           !compare(as_node(node)->value, as_node(position)->value)) {
+      position = position->next;
+    }
+    if (position == &fakeNode_) {
+      splice(end(), list);
+      return;
+    }
+    BaseNode* back = node;
+    size_t count = 1;
+    while (back->next != &list.fakeNode_ and
+           compare(as_node(back->next)->value, as_node(position)->value)) {
+      back = back->next;
+      count++;
+    }
+    list.unlink_nodes(node, back);
+    link_nodes(position, node, back);
+    list.size_ -= count;
+    size_ += count;
+  }
+}
+
+template <typename T, typename Allocator>
+template <typename Predicate>
+size_t List<T, Allocator>::remove_if(Predicate predicate) {
+  // Removed nodes are only destroyed at the end, so the predicate may refer
+  // to an element of the list.
+  BaseNode* removed = nullptr;
+  size_t count = 0;
+  for (BaseNode* node = fakeNode_.next; node != &fakeNode_;) {
+    BaseNode* next = node->next;
+    if (predicate(as_node(node)->value)) {
+      unlink_nodes(node, node);
+      node->next = removed;
+      removed = node;
+      count++;
+    }
+    node = next;
+  }
+  size_ -= count;
+  destroy_nodes(removed);
+  return count;
+}
+
+template <typename T, typename Allocator>
+template <typename BinaryPredicate>
+size_t List<T, Allocator>::unique(BinaryPredicate predicate) {
+  BaseNode* removed = nullptr;
+  size_t count = 0;
+  if (size_ != 0) {
+    for (BaseNode* node = fakeNode_.next; node->next != &fakeNode_;) {
+      BaseNode* next = node->next;
+      if (predicate(as_node(node)->value, as_node(next)->value)) {
+        unlink_nodes(next, next);
+        next->next = removed;
+        removed = next;
+        count++;
+      } else {
+        node = next;
+      }
+    }
+  }
+  size_ -= count;
+  destroy_nodes(removed);
+  return count;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::reverse() {
+  BaseNode* node = &fakeNode_;
+  do {
+    std::swap(node->prev, node->next);
+    node = node->prev;
+  } while (node != &fakeNode_);
+}
+
+template <typename T, typename Allocator>
+template <typename Compare>
+typename List<T, Allocator>::BaseNode* List<T, Allocator>::merge_chains(
+    BaseNode* first, BaseNode* second, Compare& compare) {
+  BaseNode* head = nullptr;
+  BaseNode** link = &head;
+  while (first != nullptr and second != nullptr) {
+    if (compare(as_node(second)->value, as_node(first)->value)) {
+      *link = second;
+      second = second->next;
+    } else {
+      *link = first;
+      first = first->next;
+    }
+    link = &(*link)->next;
+  }
+  *link = (first != nullptr ? first : second);
+  return head;
+}
+
+template <typename T, typename Allocator>
+template <typename Compare>
+void List<T, Allocator>::sort(Compare compare) {
+  if (size_ < 2) {
+    return;
+  }
+  // bins[i] holds a sorted run of 2^i nodes, or nothing; older runs sit in
+  // higher bins, so merging them first keeps the sort stable. The runs are
+  // singly linked and the prev links are rebuilt at the end.
+  BaseNode* bins[64] = {};
+  fakeNode_.prev->next = nullptr;
+  for (BaseNode* node = fakeNode_.next; node != nullptr;) {
+    BaseNode* carry = node;
+    node = node->next;
+    carry->next = nullptr;
+    size_t i = 0;
+    for (; bins[i] != nullptr; i++) {
+      carry = merge_chains(bins[i], carry, compare);
+      bins[i] = nullptr;
+    }
+    bins[i] = carry;
+  }
+  BaseNode* sorted = nullptr;
+  for (BaseNode* bin : bins) {
+    if (bin != nullptr) {
+      sorted = merge_chains(bin, sorted, compare);
+    }
+  }
+  BaseNode* prev = &fakeNode_;
+  for (BaseNode* node = sorted; node != nullptr; node = node->next) {
+    node->prev = prev;
+    prev->next = node;
+    prev = node;
+  }
+  prev->next = &fakeNode_;
+  fakeNode_.prev = prev;
+}
+
+// Size buckets of ArenaStatsSnapshot::allocations_by_size: bucket i counts
+// requests of up to 2^i bytes (and more than 2^(i-1)); the last bucket takes
+// everything larger.
+inline constexpr size_t kArenaSizeBuckets = 16;
+
+struct ArenaStatsSnapshot {
+  size_t allocations = 0;
+  size_t deallocations = 0;
+  // Allocations served from a size-class free list.
+  size_t reused_allocations = 0;
+  size_t failed_allocations = 0;
+  // Bytes asked for, and bytes taken from the arena for them: the
+  // difference is granule rounding plus alignment padding.
+  size_t requested_bytes = 0;
+  size_t consumed_bytes = 0;
+  size_t padding_bytes = 0;
+  // Granule-rounded bytes of the blocks not yet freed, padding excluded.
+  size_t live_bytes = 0;
+  size_t peak_live_bytes = 0;
+  // Highest offset reached in the inline array; an N of at least this much
+  // would have avoided every upstream chunk.
+  size_t inline_high_water = 0;
+  size_t upstream_bytes = 0;
+  std::array<size_t, kArenaSizeBuckets> allocations_by_size{};
+};
+
+// Instrumentation policy of StackStorage that records nothing; every hook
+// is an empty inline function, so the default storage pays nothing for it.
+struct NoArenaStats {
+  void on_allocate(size_t, size_t, size_t, bool) {}
+  void on_deallocate(size_t) {}
+  void on_failure(size_t) {}
+  void on_inline_top(size_t) {}
+  void on_upstream(size_t) {}
+};
+
+// Instrumentation policy that counts everything in ArenaStatsSnapshot.
+// Counters are relaxed atomics so that concurrent arenas can use it too.
+class ArenaStats {
+ public:
+  void on_allocate(size_t requested, size_t consumed, size_t padding,
+                   bool reused);
+  void on_deallocate(size_t consumed);
+  void on_failure(size_t) {
+    failed_allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void on_inline_top(size_t offset) { raise(inline_high_water_, offset); }
+  void on_upstream(size_t bytes) {
+    upstream_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  ArenaStatsSnapshot snapshot() const;
+
+ private:
+  using Counter = std::atomic<size_t>;
+
+  Counter allocations_{0};
+  Counter deallocations_{0};
+  Counter reused_allocations_{0};
+  Counter failed_allocations_{0};
+  Counter requested_bytes_{0};
+  Counter consumed_bytes_{0};
+  Counter padding_bytes_{0};
+  Counter live_bytes_{0};
+  Counter peak_live_bytes_{0};
+  Counter inline_high_water_{0};
+  Counter upstream_bytes_{0};
+  std::array<Counter, kArenaSizeBuckets> allocations_by_size_{};
+
+  static void raise(Counter& maximum, size_t value) {
+    size_t current = maximum.load(std::memory_order_relaxed);
+    while (current < value and
+           !maximum.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed)) {
+    }
+  }
+};
+
+inline void ArenaStats::on_allocate(size_t requested, size_t consumed,
+                                    size_t padding, bool reused) {
+  allocations_.fetch_add(1, std::memory_order_relaxed);
+  if (reused) {
+    reused_allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  requested_bytes_.fetch_add(requested, std::memory_order_relaxed);
+  consumed_bytes_.fetch_add(consumed, std::memory_order_relaxed);
+  padding_bytes_.fetch_add(padding, std::memory_order_relaxed);
+  size_t bucket = std::min<size_t>(std::bit_width(requested - (requested > 0)),
+                                   kArenaSizeBuckets - 1);
+  allocations_by_size_[bucket].fetch_add(1, std::memory_order_relaxed);
+  // Padding is never handed back by deallocate(), so live bytes leave it
+  // out; padding_bytes accounts for it.
+  size_t live = consumed - padding;
+  raise(peak_live_bytes_,
+        live_bytes_.fetch_add(live, std::memory_order_relaxed) + live);
+}
+
+inline void ArenaStats::on_deallocate(size_t consumed) {
+  deallocations_.fetch_add(1, std::memory_order_relaxed);
+  live_bytes_.fetch_sub(consumed, std::memory_order_relaxed);
+}
+
+inline ArenaStatsSnapshot ArenaStats::snapshot() const {
+  ArenaStatsSnapshot snapshot;
+  snapshot.allocations = allocations_.load(std::memory_order_relaxed);
+  snapshot.deallocations = deallocations_.load(std::memory_order_relaxed);
+  snapshot.reused_allocations =
+      reused_allocations_.load(std::memory_order_relaxed);
+  snapshot.failed_allocations =
+      failed_allocations_.load(std::memory_order_relaxed);
+  snapshot.requested_bytes = requested_bytes_.load(std::memory_order_relaxed);
+  snapshot.consumed_bytes = consumed_bytes_.load(std::memory_order_relaxed);
+  snapshot.padding_bytes = padding_bytes_.load(std::memory_order_relaxed);
+  snapshot.live_bytes = live_bytes_.load(std::memory_order_relaxed);
+  snapshot.peak_live_bytes = peak_live_bytes_.load(std::memory_order_relaxed);
+  snapshot.inline_high_water =
+      inline_high_water_.load(std::memory_order_relaxed);
+  snapshot.upstream_bytes = upstream_bytes_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kArenaSizeBuckets; i++) {
+    snapshot.allocations_by_size[i] =
+        allocations_by_size_[i].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+// Threading policies of StackStorage. A SingleThreadedArena is used by one
+// thread at a time and recycles freed blocks; a ConcurrentArena can be
+// allocated from by several threads at once.
+struct SingleThreadedArena {};
+struct ConcurrentArena {};
+
+// Bump arena shared by every StackAllocator that points at it. Freed memory
+// is reclaimed in two ways: a block that ends at the top of the stack rolls
+// the stack back, and any other block of at most kMaxPooled bytes goes to a
+// free list for its size class and is handed out again by the next
+// allocation of that class. Larger blocks below the top are not reused, so
+// big allocations should be freed in LIFO order.
+//
+// A storage constructed with an upstream resource does not throw once
+// array_ is full: like std::pmr::monotonic_buffer_resource it carries on in
+// geometrically growing chunks from upstream, which are only returned by
+// reset() or the destructor.
+//
+// With the ConcurrentArena policy the bump offset is advanced with one
+// fetch_add and only installing a new upstream chunk takes a lock. Such a
+// storage is purely monotonic; deallocate() is a no-op and reset() must not
+// race with allocation. The policy is chosen at compile time, so the
+// single-threaded storage carries none of this.
+//
+// Stats is the instrumentation policy: NoArenaStats compiles to nothing,
+// ArenaStats records what stats().snapshot() reports.
+template <size_t N, typename Stats = NoArenaStats,
+          typename Threading = SingleThreadedArena>
 struct StackStorage {
+  static constexpr bool kConcurrent =
+      std::is_same_v<Threading, ConcurrentArena>;
+  static constexpr size_t kGranule = sizeof(void*);
+  static constexpr size_t kMaxPooled = 256;
+  static constexpr size_t kSizeClasses = kMaxPooled / kGranule;
+
   StackStorage() = default;
-  StackStorage(const StackStorage<N>& stack_storage) = delete;
-  StackStorage& operator=(const StackStorage<N>& stack_storage) = delete;
-  ~StackStorage() = default;
+  explicit StackStorage(std::pmr::memory_resource* upstream)
+      : upstream_(upstream) {}
+  StackStorage(const StackStorage& stack_storage) = delete;
+  StackStorage& operator=(const StackStorage& stack_storage) = delete;
+  ~StackStorage() { release_chunks(); }
+
+  void* allocate(size_t requested, size_t alignment);
+  void deallocate(void* pointer, size_t bytes);
+
+  // Frees everything at once: every pointer handed out becomes invalid and
+  // the upstream chunks are returned.
+  void reset();
+
+  // The calling thread's own arena, created on first use and backed by
+  // operator new once its N inline bytes run out. Memory from it must not
+  // outlive the thread.
+  static StackStorage& for_this_thread();
+
+  const Stats& stats() const { return stats_; }
+
+  // Sizes are rounded up to the granule so that a freed block can hold the
+  // free list link and fits any later request of the same class. Together
+  // with the max-aligned buffers this keeps every bump offset a multiple of
+  // the granule.
+  static size_t round_up(size_t bytes) {
+    return (bytes == 0 ? kGranule : (bytes + kGranule - 1) & ~(kGranule - 1));
+  }
+
+  alignas(std::max_align_t) char array_[N];
+  std::atomic<size_t> last_used_{0};
+  void* free_lists_[kSizeClasses] = {};
+  [[no_unique_address]] Stats stats_;
+
+  // Upstream chunks, newest first; allocation bumps `used` in the newest
+  // one.
+  struct alignas(std::max_align_t) Chunk {
+    Chunk* next;
+    size_t size;
+    std::atomic<size_t> used{0};
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+  std::pmr::memory_resource* upstream_ = nullptr;
+  std::atomic<Chunk*> chunks_{nullptr};
+  std::mutex chunk_mutex_;
+
+  void* bump(char* base, std::atomic<size_t>& used, size_t capacity,
+             size_t bytes, size_t alignment, size_t& padding, size_t& end);
+  void* allocate_from_chunk(size_t bytes, size_t alignment,
+                            size_t& padding);
+  void release_chunks();
+};
+
+template <size_t N, typename Stats, typename Threading>
+StackStorage<N, Stats, Threading>&
+StackStorage<N, Stats, Threading>::for_this_thread() {
+  thread_local std::unique_ptr<StackStorage> arena =
+      std::make_unique<StackStorage>(std::pmr::new_delete_resource());
+  return *arena;
+}
+
+// Carves `bytes` out of [base + used, base + capacity), or returns nullptr;
+// `padding` and `end` receive the bytes skipped for alignment and the new
+// top. In concurrent mode the padding an over-aligned request may need is
+// reserved up front, so one fetch_add claims the whole block.
+template <size_t N, typename Stats, typename Threading>
+void* StackStorage<N, Stats, Threading>::bump(char* base,
+                                              std::atomic<size_t>& used,
+                                              size_t capacity, size_t bytes,
+                                              size_t alignment,
+                                              size_t& padding, size_t& end) {
+  auto address = reinterpret_cast<uintptr_t>(base);
+  size_t offset;
+  if constexpr (kConcurrent) {
+    padding = (alignment > kGranule ? alignment - kGranule : 0);
+    offset = used.fetch_add(bytes + padding, std::memory_order_relaxed);
+    end = offset + bytes + padding;
+    offset = ((address + offset + alignment - 1) & ~(alignment - 1)) - address;
+  } else {
+    size_t top = used.load(std::memory_order_relaxed);
+    offset = ((address + top + alignment - 1) & ~(alignment - 1)) - address;
+    padding = offset - top;
+    end = offset + bytes;
+  }
+  if (end > capacity) {
+    return nullptr;
+  }
+  if constexpr (!kConcurrent) {
+    used.store(end, std::memory_order_relaxed);
+  }
+  return base + offset;
+}
+
+template <size_t N, typename Stats, typename Threading>
+void* StackStorage<N, Stats, Threading>::allocate(size_t requested,
+                                                  size_t alignment) {
+  size_t bytes = round_up(requested);
+  if (!kConcurrent and bytes <= kMaxPooled) {
+    void*& head = free_lists_[bytes / kGranule - 1];
+    if (head != nullptr and
+        reinterpret_cast<uintptr_t>(head) % alignment == 0) {
+      void* block = head;
+      head = *static_cast<void**>(block);
+      stats_.on_allocate(requested, bytes, 0, true);
+      return block;
+    }
+  }
+  size_t padding;
+  size_t end;
+  void* block = bump(array_, last_used_, N, bytes, alignment, padding, end);
+  if (block != nullptr) {
+    stats_.on_inline_top(end);
+  } else if (upstream_ != nullptr) {
+    block = allocate_from_chunk(bytes, alignment, padding);
+  } else {
+    stats_.on_failure(requested);
+    throw std::bad_alloc();
+  }
+  stats_.on_allocate(requested, bytes + padding, padding, false);
+  return block;
+}
+
+template <size_t N, typename Stats, typename Threading>
+void* StackStorage<N, Stats, Threading>::allocate_from_chunk(
+    size_t bytes, size_t alignment, size_t& padding) {
+  while (true) {
+    Chunk* chunk = chunks_.load(std::memory_order_acquire);
+    size_t end;
+    if (chunk != nullptr) {
+      if (void* block =
+              bump(chunk->data(), chunk->used, chunk->size - sizeof(Chunk),
+                   bytes, alignment, padding, end)) {
+        return block;
+      }
+    }
+    std::unique_lock<std::mutex> lock(chunk_mutex_, std::defer_lock);
+    if constexpr (kConcurrent) {
+      lock.lock();
+      if (chunks_.load(std::memory_order_relaxed) != chunk) {
+        continue;
+      }
+    }
+    size_t size = std::max<size_t>(
+        (chunk == nullptr ? std::max<size_t>(N, 1024) : chunk->size) * 2,
+        sizeof(Chunk) + bytes + alignment);
+    auto* fresh = new (upstream_->allocate(size, alignof(Chunk))) Chunk;
+    fresh->next = chunk;
+    fresh->size = size;
+    chunks_.store(fresh, std::memory_order_release);
+    stats_.on_upstream(size);
+  }
+}
+
+template <size_t N, typename Stats, typename Threading>
+void StackStorage<N, Stats, Threading>::deallocate(void* pointer,
+                                                   size_t bytes) {
+  bytes = round_up(bytes);
+  stats_.on_deallocate(bytes);
+  if constexpr (kConcurrent) {
+    return;
+  }
+  char* block = static_cast<char*>(pointer);
+  Chunk* chunk = chunks_.load(std::memory_order_relaxed);
+  if (block + bytes == array_ + last_used_.load(std::memory_order_relaxed)) {
+    last_used_.store(block - array_, std::memory_order_relaxed);
+  } else if (chunk != nullptr and
+             block + bytes == chunk->data() + chunk->used.load(
+                                                  std::memory_order_relaxed)) {
+    chunk->used.store(block - chunk->data(), std::memory_order_relaxed);
+  } else if (bytes <= kMaxPooled) {
+    void*& head = free_lists_[bytes / kGranule - 1];
+    *static_cast<void**>(pointer) = head;
+    head = pointer;
+  }
+}
+
+template <size_t N, typename Stats, typename Threading>
+void StackStorage<N, Stats, Threading>::reset() {
+  release_chunks();
+  last_used_.store(0, std::memory_order_relaxed);
+  std::fill(std::begin(free_lists_), std::end(free_lists_), nullptr);
+}
+
+template <size_t N, typename Stats, typename Threading>
+void StackStorage<N, Stats, Threading>::release_chunks() {
+  Chunk* chunk = chunks_.exchange(nullptr, std::memory_order_acquire);
+  while (chunk != nullptr) {
+    Chunk* next = chunk->next;
+    size_t size = chunk->size;
+    chunk->~Chunk();
+    upstream_->deallocate(chunk, size, alignof(Chunk));
+    chunk = next;
+  }
+}
 
-  char array_[N];
-  size_t last_used_ = 0;
+// std::pmr::memory_resource view of a StackStorage, so that pmr containers
+// can share the arena with StackAllocator-based ones.
+template <size_t N, typename Stats = NoArenaStats,
+          typename Threading = SingleThreadedArena>
+class StackMemoryResource : public std::pmr::memory_resource {
+ public:
+  explicit StackMemoryResource(StackStorage<N, Stats, Threading>& storage)
+      : storage_(&storage) {}
+
+  StackStorage<N, Stats, Threading>& storage() const { return *storage_; }
+
+ private:
+  StackStorage<N, Stats, Threading>* storage_;
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return storage_->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* pointer, size_t bytes, size_t) override {
+    storage_->deallocate(pointer, bytes);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& resource) const noexcept override {
+    auto* other = dynamic_cast<const StackMemoryResource*>(&resource);
+    return other != nullptr and other->storage_ == storage_;
+  }
 };
 
-template <typename T, size_t N>
+// Allocator over a StackStorage; copies and rebinds share the storage. A
+// List or Deque on it needs an allocator bound to a storage, either one
+// the caller owns or the thread's arena from for_this_thread():
+//
+//   List<int, StackAllocator<int, N>> list(
+//       StackAllocator<int, N>::for_this_thread());
+template <typename T, size_t N, typename Stats = NoArenaStats,
+          typename Threading = SingleThreadedArena>
 struct StackAllocator {
   using value_type = T;
   using pointer = value_type*;
 
   template <class U>
   struct rebind {
-    using other = StackAllocator<U, N>;
+    using other = StackAllocator<U, N, Stats, Threading>;
   };
 
   template <class U>
-  StackAllocator(const StackAllocator<U, N>& other)
+  StackAllocator(const StackAllocator<U, N, Stats, Threading>& other)
       : storage_(other.storage_) {}
 
+  // Not bound to any storage: it has to be assigned a bound allocator
+  // before anything is allocated through it. Default-constructed containers
+  // therefore cost nothing until they get a real allocator.
   StackAllocator() = default;
 
-  StackAllocator(StackStorage<N>& stack_storage) : storage_(&stack_storage){};
+  // Allocator on the calling thread's arena (see
+  // StackStorage::for_this_thread()), which costs N bytes per thread on
+  // first use. The arena dies with the thread, so a container using it has
+  // to be destroyed or cleared before then, and must not free its memory
+  // from another thread.
+  static StackAllocator for_this_thread() {
+    return StackAllocator(StackStorage<N, Stats, Threading>::for_this_thread());
+  }
+
+  StackAllocator(StackStorage<N, Stats, Threading>& stack_storage)
+      : storage_(&stack_storage){};
 
-  StackAllocator(const StackAllocator<T, N>& alloc)
+  StackAllocator(const StackAllocator<T, N, Stats, Threading>& alloc)
       : storage_(alloc.storage_){};
-  StackAllocator& operator=(const StackAllocator<T, N>& alloc);
+  StackAllocator& operator=(
+      const StackAllocator<T, N, Stats, Threading>& alloc);
   ~StackAllocator() = default;
 
   pointer allocate(const size_t kN);
 
-  void deallocate(const T*, const size_t){};
+  void deallocate(T* pointer, const size_t kN) {
+    storage_->deallocate(pointer, kN * sizeof(value_type));
+  }
 
-  bool operator==(const StackAllocator& alloc) {
+  bool operator==(const StackAllocator& alloc) const {
     return storage_ == alloc.storage_;
   }
 
-  bool operator!=(const StackAllocator& alloc) { return !(alloc == *this); }
+  bool operator!=(const StackAllocator& alloc) const {
+    return !(alloc == *this);
+  }
 
-  StackStorage<N>* storage_;
+  StackStorage<N, Stats, Threading>* storage_ = nullptr;
 };
 
-template <typename T, size_t N>
-typename StackAllocator<T, N>::pointer StackAllocator<T, N>::allocate(
-    const size_t kN) {
-  void* begin = storage_->array_ + storage_->last_used_;
-  size_t free = N - storage_->last_used_;
-  if (std::align(alignof(value_type), kN * sizeof(value_type), begin, free)) {
-    storage_->last_used_ =
-        reinterpret_cast<char*>(reinterpret_cast<char*>(begin) +
-                                kN * sizeof(value_type)) -
-        storage_->array_;
-    return reinterpret_cast<value_type*>(begin);
-  }
-  throw std::bad_alloc();
+template <typename T, size_t N, typename Stats, typename Threading>
+typename StackAllocator<T, N, Stats, Threading>::pointer
+StackAllocator<T, N, Stats, Threading>::allocate(const size_t kN) {
+  return static_cast<pointer>(
+      storage_->allocate(kN * sizeof(value_type), alignof(value_type)));
 }
 
-template <typename T, size_t N>
-StackAllocator<T, N>& StackAllocator<T, N>::operator=(
-    const StackAllocator<T, N>& alloc) {
+template <typename T, size_t N, typename Stats, typename Threading>
+StackAllocator<T, N, Stats, Threading>&
+StackAllocator<T, N, Stats, Threading>::operator=(
+    const StackAllocator<T, N, Stats, Threading>& alloc) {
   StackAllocator temporary(alloc);
   std::swap(storage_, temporary.storage_);
   return *this;
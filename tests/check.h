@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Unlike assert, stays on in release builds.
+#define CHECK(condition)                                             \
+  do {                                                               \
+    if (!(condition)) {                                              \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,    \
+                   __LINE__, #condition);                            \
+      std::abort();                                                  \
+    }                                                                \
+  } while (false)
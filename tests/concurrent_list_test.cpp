@@ -0,0 +1,142 @@
+// Behaviour of ConcurrentList, single-threaded and under concurrent pushes,
+// reads and removals. Build with -pthread; worth running under
+// -fsanitize=thread as well.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../concurrent_list.h"
+#include "check.h"
+
+namespace {
+
+std::vector<int> contents(const ConcurrentList<int>& list) {
+  std::vector<int> result;
+  list.for_each([&result](int value) { result.push_back(value); });
+  return result;
+}
+
+void test_sequential() {
+  ConcurrentList<int> list;
+  CHECK(list.empty() and list.begin() == list.end());
+  list.push_front(1);
+  list.push_back(2);
+  list.push_front(0);
+  list.push_back(3);
+  CHECK((contents(list) == std::vector<int>{0, 1, 2, 3}));
+  CHECK(list.remove(3) == 1 and list.size() == 3);
+  list.push_back(4);
+  CHECK(list.remove_if([](int value) { return value % 2 == 0; }) == 3);
+  CHECK((contents(list) == std::vector<int>{1}));
+  list.clear();
+  CHECK(list.empty() and contents(list).empty());
+  list.push_front(7);
+  list.push_back(8);
+  CHECK((contents(list) == std::vector<int>{7, 8}));
+}
+
+// Pushers append while a remover clears the list right behind them, so
+// nodes next to the tail are unlinked while tail_ is being swung.
+void test_unlink_at_tail() {
+  constexpr int kPushers = 4;
+  constexpr int kPushes = 50000;
+  ConcurrentList<int> list;
+  std::atomic<int> running{kPushers};
+  std::vector<std::thread> pushers;
+  for (int pusher = 0; pusher < kPushers; pusher++) {
+    pushers.emplace_back([&list, &running, pusher] {
+      for (int i = 0; i < kPushes; i++) {
+        if (i % 8 == 0) {
+          list.push_front(pusher);
+        } else {
+          list.push_back(pusher);
+        }
+      }
+      running--;
+    });
+  }
+  size_t removed = 0;
+  while (running.load() != 0) {
+    removed += list.remove_if([](int) { return true; });
+  }
+  for (auto& pusher : pushers) {
+    pusher.join();
+  }
+  removed += list.remove_if([](int) { return true; });
+  CHECK(removed == size_t(kPushers) * kPushes);
+  CHECK(list.empty() and contents(list).empty());
+  list.push_back(1);
+  CHECK((contents(list) == std::vector<int>{1}));
+}
+
+// Mixed producers, a reader and a remover; every element is seen at most
+// once and the counts add up.
+void test_mixed() {
+  constexpr int kPushers = 6;
+  constexpr int kPushes = 5000;
+  ConcurrentList<std::string> list;
+  std::atomic<bool> done{false};
+  std::vector<std::thread> pushers;
+  for (int pusher = 0; pusher < kPushers; pusher++) {
+    pushers.emplace_back([&list, pusher] {
+      for (int i = 0; i < kPushes; i++) {
+        std::string value = std::to_string(pusher * kPushes + i);
+        if (i % 3 == 0) {
+          list.push_front(value);
+        } else {
+          list.push_back(value);
+        }
+      }
+    });
+  }
+  std::thread reader([&list, &done] {
+    while (!done.load()) {
+      auto guard = list.pin();
+      std::set<std::string> seen;
+      for (const std::string& value : list) {
+        CHECK(seen.insert(value).second);
+      }
+    }
+  });
+  auto divisible_by_five = [](const std::string& value) {
+    return std::stoi(value) % 5 == 0;
+  };
+  size_t removed = 0;
+  std::thread remover([&] {
+    while (!done.load()) {
+      removed += list.remove_if(divisible_by_five);
+    }
+  });
+  for (auto& pusher : pushers) {
+    pusher.join();
+  }
+  done = true;
+  reader.join();
+  remover.join();
+  removed += list.remove_if(divisible_by_five);
+  CHECK(removed == kPushers * kPushes / 5);
+  std::set<int> left;
+  list.for_each([&left](const std::string& value) {
+    CHECK(std::stoi(value) % 5 != 0);
+    left.insert(std::stoi(value));
+  });
+  CHECK(left.size() == kPushers * kPushes - removed);
+  CHECK(list.size() == left.size());
+}
+
+}  // namespace
+
+int main() {
+  test_sequential();
+  for (int round = 0; round < 20; round++) {
+    test_unlink_at_tail();
+  }
+  test_mixed();
+  std::puts("ok");
+  return 0;
+}
@@ -0,0 +1,106 @@
+// Runs Deque on a StackAllocator arena and checks that none of it reaches
+// the global operator new, which this file replaces with a counter.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "../deque.h"
+#include "../stackallocator.h"
+#include "check.h"
+
+namespace {
+
+size_t global_news = 0;
+
+}  // namespace
+
+void* operator new(size_t bytes) {
+  global_news++;
+  if (void* pointer = std::malloc(bytes == 0 ? 1 : bytes)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes) { return operator new(bytes); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+
+namespace {
+
+constexpr size_t kArenaBytes = 1 << 20;
+
+using Alloc = StackAllocator<int, kArenaBytes>;
+using StackDeque = Deque<int, Alloc>;
+
+void test_push_pop(StackStorage<kArenaBytes>& storage) {
+  StackDeque deque{Alloc(storage)};
+  for (int i = 0; i < 10000; i++) {
+    deque.push_back(i);
+    deque.push_front(-i);
+  }
+  CHECK(deque.size() == 20000);
+  CHECK(deque[0] == -9999 and deque[19999] == 9999);
+  for (int i = 0; i < 5000; i++) {
+    deque.pop_back();
+    deque.pop_front();
+  }
+  CHECK(deque.size() == 10000);
+  deque.shrink_to_fit();
+  deque.clear();
+  CHECK(deque.size() == 0);
+}
+
+void test_copy_move_swap(StackStorage<kArenaBytes>& storage) {
+  StackDeque first{Alloc(storage)};
+  for (int i = 0; i < 1000; i++) {
+    first.push_back(i);
+  }
+  StackDeque copy(first);
+  CHECK(copy.size() == 1000 and copy[999] == 999);
+  StackDeque moved(std::move(copy));
+  CHECK(moved.size() == 1000);
+  StackDeque second{Alloc(storage)};
+  second.push_back(-1);
+  second = first;
+  CHECK(second.size() == 1000);
+  second = std::move(moved);
+  second.swap(first);
+  CHECK(first.size() == 1000 and second.size() == 1000);
+}
+
+void test_strings(StackStorage<kArenaBytes>& storage) {
+  using StringAlloc = StackAllocator<std::string, kArenaBytes>;
+  Deque<std::string, StringAlloc> deque{StringAlloc(storage)};
+  for (int i = 0; i < 100; i++) {
+    // Short enough for the small-string buffer.
+    deque.emplace_back("x");
+  }
+  CHECK(deque.size() == 100 and deque[99] == "x");
+}
+
+}  // namespace
+
+int main() {
+  // Static, so the arena itself never goes through operator new.
+  static StackStorage<kArenaBytes> storage;
+  global_news = 0;
+
+  test_push_pop(storage);
+  test_copy_move_swap(storage);
+  test_strings(storage);
+
+  CHECK(global_news == 0);
+  std::puts("ok");
+  return 0;
+}
@@ -0,0 +1,164 @@
+// Behaviour of FixedDeque: both ends around the ring boundary, the full
+// ring, iterators, copies and moves, and that every element constructed
+// is destroyed exactly once.
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../fixed_deque.h"
+#include "check.h"
+
+namespace {
+
+int live = 0;
+
+struct Tracked {
+  Tracked(int value) : value(value) { live++; }
+  Tracked(const Tracked& other) : value(other.value) { live++; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() { live--; }
+
+  int value;
+};
+
+template <typename Deque>
+bool same(const Deque& deque, const std::deque<int>& expected) {
+  if (deque.size() != expected.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (deque[i].value != expected[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_against_std_deque() {
+  {
+    FixedDeque<Tracked, 64> deque;
+    std::deque<int> expected;
+    std::mt19937 random(7);
+    for (int step = 0; step < 100000; ++step) {
+      int value = static_cast<int>(random() % 1000);
+      switch (random() % 4) {
+        case 0:
+          CHECK(deque.try_push_back(Tracked(value)) == (expected.size() < 64));
+          if (expected.size() < 64) {
+            expected.push_back(value);
+          }
+          break;
+        case 1:
+          CHECK(deque.try_push_front(Tracked(value)) ==
+                (expected.size() < 64));
+          if (expected.size() < 64) {
+            expected.push_front(value);
+          }
+          break;
+        case 2:
+          if (!expected.empty()) {
+            deque.pop_back();
+            expected.pop_back();
+          }
+          break;
+        default:
+          if (!expected.empty()) {
+            deque.pop_front();
+            expected.pop_front();
+          }
+      }
+      CHECK(live == static_cast<int>(expected.size()));
+    }
+    CHECK(same(deque, expected));
+  }
+  CHECK(live == 0);
+}
+
+void test_full_ring() {
+  FixedDeque<int, 8> deque;
+  for (int i = 0; i < 8; ++i) {
+    deque.push_front(i);
+  }
+  CHECK(deque.full() and deque.size() == deque.capacity());
+  CHECK(!deque.try_push_back(8) and !deque.try_push_front(8));
+  bool threw = false;
+  try {
+    deque.push_back(8);
+  } catch (const std::length_error&) {
+    threw = true;
+  }
+  CHECK(threw and deque.size() == 8 and deque[0] == 7 and deque[7] == 0);
+  threw = false;
+  try {
+    deque.at(8);
+  } catch (const std::out_of_range&) {
+    threw = true;
+  }
+  CHECK(threw and deque.at(7) == 0);
+}
+
+void test_iterators() {
+  FixedDeque<int, 16> deque;
+  for (int i = 0; i < 10; ++i) {
+    deque.push_back(i);
+  }
+  for (int i = 0; i < 7; ++i) {
+    deque.pop_front();
+    deque.push_back(10 + i);
+  }
+  // The elements 7..16 now wrap around the end of the ring.
+  int expected = 7;
+  for (int value : deque) {
+    CHECK(value == expected++);
+  }
+  CHECK(expected == 17);
+  CHECK(deque.end() - deque.begin() == 10);
+  CHECK(*(deque.begin() + 9) == 16 and deque.begin()[4] == 11);
+  CHECK(*deque.rbegin() == 16 and *std::prev(deque.rend()) == 7);
+  FixedDeque<int, 16>::const_iterator first = deque.begin();
+  CHECK(first == deque.cbegin() and first < deque.cend());
+}
+
+void test_copy_and_move() {
+  {
+    FixedDeque<Tracked, 16> deque;
+    for (int i = 0; i < 12; ++i) {
+      deque.emplace_front(i);
+    }
+    FixedDeque<Tracked, 16> copy(deque);
+    CHECK(copy.size() == 12 and copy[0].value == 11 and live == 24);
+    FixedDeque<Tracked, 16> moved(std::move(copy));
+    CHECK(moved.size() == 12 and moved[11].value == 0);
+    FixedDeque<Tracked, 16> assigned;
+    assigned.emplace_back(100);
+    assigned = deque;
+    CHECK(assigned.size() == 12 and assigned[5].value == 6);
+    assigned.clear();
+    CHECK(assigned.empty());
+    assigned = std::move(moved);
+    CHECK(assigned.size() == 12);
+    assigned.swap(deque);
+    CHECK(assigned.size() == 12 and deque.size() == 12);
+  }
+  CHECK(live == 0);
+  FixedDeque<std::string, 4> strings(3, "abc");
+  CHECK(strings.size() == 3 and strings[2] == "abc");
+}
+
+}  // namespace
+
+int main() {
+  test_against_std_deque();
+  test_full_ring();
+  test_iterators();
+  test_copy_and_move();
+  std::puts("ok");
+}
@@ -0,0 +1,148 @@
+// Behaviour of LruCache: recency order, weighted eviction, oversized
+// values and a table allocation that fails in the middle of put().
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../lru_cache.h"
+#include "check.h"
+
+namespace {
+
+std::vector<int> keys(const LruCache<int, std::string>& cache) {
+  std::vector<int> result;
+  for (const auto& entry : cache) {
+    result.push_back(entry.key);
+  }
+  return result;
+}
+
+void test_recency() {
+  LruCache<int, std::string> cache(3);
+  std::vector<int> evicted;
+  cache.set_eviction_callback(
+      [&evicted](const int& key, std::string&) { evicted.push_back(key); });
+  cache.put(1, "a");
+  cache.put(2, "b");
+  cache.put(3, "c");
+  CHECK(cache.get(1) != nullptr);
+  CHECK(*cache.peek(2) == "b");
+  cache.put(4, "d");
+  CHECK((keys(cache) == std::vector<int>{4, 1, 3}));
+  CHECK((evicted == std::vector<int>{2}));
+  cache.put(3, "C");
+  CHECK(*cache.get(3) == "C" and cache.size() == 3);
+  CHECK(cache.erase(1) and !cache.erase(1));
+  CHECK((keys(cache) == std::vector<int>{3, 4}));
+  cache.set_capacity(1);
+  CHECK((keys(cache) == std::vector<int>{3}));
+  cache.clear();
+  CHECK(cache.empty() and cache.get(3) == nullptr);
+}
+
+LruCache<int, std::string>::Weigher by_length() {
+  return [](const int&, const std::string& value) { return value.size(); };
+}
+
+void test_weights() {
+  LruCache<int, std::string> cache(10, by_length());
+  for (int key = 0; key < 5; key++) {
+    cache.put(key, "xx");
+  }
+  CHECK(cache.size() == 5 and cache.weight() == 10);
+  cache.put(5, "yyyy");
+  CHECK(cache.size() == 4 and cache.weight() == 10);
+  CHECK(!cache.contains(0) and !cache.contains(1) and cache.contains(5));
+}
+
+void test_oversized_value() {
+  LruCache<int, std::string> cache(10, by_length());
+  std::vector<int> evicted;
+  cache.set_eviction_callback(
+      [&evicted](const int& key, std::string&) { evicted.push_back(key); });
+  for (int key = 0; key < 5; key++) {
+    cache.put(key, "xx");
+  }
+  cache.put(99, std::string(20, 'z'));
+  CHECK(cache.size() == 5 and cache.weight() == 10);
+  CHECK(!cache.contains(99));
+  CHECK((evicted == std::vector<int>{99}));
+
+  // Replacing a key with an oversized value drops only that key.
+  cache.put(2, std::string(11, 'z'));
+  CHECK(cache.size() == 4 and cache.weight() == 8 and !cache.contains(2));
+  CHECK((evicted == std::vector<int>{99, 2}));
+}
+
+// Fails every array allocation (the slot table) while armed; list nodes
+// are single-object allocations and still succeed.
+bool fail_tables = false;
+
+template <typename T>
+struct FailingTableAllocator {
+  using value_type = T;
+
+  FailingTableAllocator() = default;
+  template <typename U>
+  FailingTableAllocator(const FailingTableAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    if (fail_tables and count > 1) {
+      throw std::bad_alloc();
+    }
+    return std::allocator<T>().allocate(count);
+  }
+  void deallocate(T* pointer, size_t count) {
+    std::allocator<T>().deallocate(pointer, count);
+  }
+
+  template <typename U>
+  bool operator==(const FailingTableAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const FailingTableAllocator<U>&) const {
+    return false;
+  }
+};
+
+void test_failed_rehash() {
+  using Alloc = FailingTableAllocator<std::pair<int, std::string>>;
+  LruCache<int, std::string, Alloc> cache(1000, by_length());
+  size_t failures = 0;
+  for (int key = 0; key < 100; key++) {
+    fail_tables = (key >= 7);
+    try {
+      cache.put(key, "x");
+    } catch (const std::bad_alloc&) {
+      failures++;
+      CHECK(!cache.contains(key));
+    }
+  }
+  fail_tables = false;
+  CHECK(failures > 0);
+  size_t entries = 0;
+  for (const auto& entry : cache) {
+    CHECK(cache.contains(entry.key));
+    entries++;
+  }
+  CHECK(entries == cache.size() and cache.size() + failures == 100);
+  cache.set_capacity(0);
+  CHECK(cache.size() == 0 and cache.weight() == 0);
+}
+
+}  // namespace
+
+int main() {
+  test_recency();
+  test_weights();
+  test_oversized_value();
+  test_failed_rehash();
+  std::puts("ok");
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Behaviour of SmallDeque: no allocation while the elements fit inline,
+// order kept across the spill to the heap and back, and shrink_to_fit
+// leaving the elements in place when a copy throws.
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../small_deque.h"
+#include "check.h"
+
+namespace {
+
+size_t allocations = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    allocations++;
+    return std::allocator<T>().allocate(count);
+  }
+  void deallocate(T* pointer, size_t count) {
+    std::allocator<T>().deallocate(pointer, count);
+  }
+
+  bool operator==(const CountingAllocator&) const { return true; }
+  bool operator!=(const CountingAllocator&) const { return false; }
+};
+
+template <typename Deque>
+bool same(const Deque& deque, const std::deque<int>& expected) {
+  if (deque.size() != expected.size()) {
+    return false;
+  }
+  size_t i = 0;
+  for (int value : deque) {
+    if (value != expected[i++]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_inline() {
+  allocations = 0;
+  SmallDeque<int, 8, CountingAllocator<int>> deque;
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      if (i % 2 == 0) {
+        deque.push_back(i);
+      } else {
+        deque.push_front(i);
+      }
+    }
+    CHECK(deque.is_inline() and deque.size() == 8);
+    CHECK(deque[0] == 7 and deque[7] == 6);
+    deque.clear();
+  }
+  CHECK(allocations == 0);
+}
+
+void test_against_std_deque() {
+  // N = 5 rounds up to an inline ring of 8.
+  SmallDeque<int, 5> deque;
+  std::deque<int> expected;
+  std::mt19937 random(9);
+  bool spilled = false;
+  bool returned = false;
+  for (int step = 0; step < 100000; ++step) {
+    int value = static_cast<int>(random() % 1000);
+    switch (random() % 6) {
+      case 0:
+        deque.push_back(value);
+        expected.push_back(value);
+        break;
+      case 1:
+        deque.emplace_front(value);
+        expected.push_front(value);
+        break;
+      case 2:
+      case 3:
+        if (!expected.empty()) {
+          deque.pop_back();
+          expected.pop_back();
+        }
+        break;
+      case 4:
+        if (!expected.empty()) {
+          deque.pop_front();
+          expected.pop_front();
+        }
+        break;
+      default:
+        deque.shrink_to_fit();
+        returned |= (expected.size() > 0 and deque.is_inline());
+    }
+    spilled |= !deque.is_inline();
+    CHECK(deque.is_inline() or expected.size() > 0);
+    CHECK(deque.size() == expected.size());
+    if (!expected.empty()) {
+      CHECK(deque[0] == expected.front() and
+            deque.at(expected.size() - 1) == expected.back());
+    }
+  }
+  CHECK(same(deque, expected) and spilled and returned);
+}
+
+int copies_left = 0;
+
+// Copying throws once copies_left runs out; moving may throw, so
+// shrink_to_fit has to copy.
+struct Fragile {
+  Fragile(int value) : value(value) {}
+  Fragile(const Fragile& other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+  }
+  Fragile(Fragile&& other) : value(other.value) {}
+  Fragile& operator=(const Fragile&) = default;
+
+  int value;
+};
+
+void test_shrink_to_fit_failure() {
+  SmallDeque<Fragile, 4> deque;
+  for (int i = 0; i < 6; ++i) {
+    deque.emplace_back(i);
+  }
+  deque.pop_back();
+  deque.pop_back();
+  CHECK(!deque.is_inline() and deque.size() == 4);
+  copies_left = 2;
+  bool threw = false;
+  try {
+    deque.shrink_to_fit();
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  CHECK(threw and !deque.is_inline() and deque.size() == 4);
+  for (int i = 0; i < 4; ++i) {
+    CHECK(deque[i].value == i);
+  }
+  copies_left = 4;
+  deque.shrink_to_fit();
+  CHECK(deque.is_inline() and deque.size() == 4 and deque[3].value == 3);
+}
+
+void test_copy_and_move() {
+  SmallDeque<std::string, 2> deque;
+  deque.push_back("a");
+  SmallDeque<std::string, 2> copy(deque);
+  deque.push_back("b");
+  deque.push_back("c");
+  SmallDeque<std::string, 2> heap_copy = deque;
+  CHECK(copy.is_inline() and copy.size() == 1 and copy[0] == "a");
+  CHECK(!heap_copy.is_inline() and heap_copy[2] == "c");
+  SmallDeque<std::string, 2> moved(std::move(deque));
+  CHECK(moved.size() == 3 and *moved.rbegin() == "c");
+  copy = moved;
+  CHECK(copy.size() == 3 and copy[1] == "b");
+}
+
+}  // namespace
+
+int main() {
+  test_inline();
+  test_against_std_deque();
+  test_shrink_to_fit_failure();
+  test_copy_and_move();
+  std::puts("ok");
+}
@@ -0,0 +1,155 @@
+// Behaviour of SoADeque: records pushed at both ends and read back by
+// field, row and iterator, column spans, copies and moves.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <tuple>
+#include <utility>
+
+#include "../soa_deque.h"
+#include "check.h"
+
+namespace {
+
+using Records = SoADeque<int64_t, double, char>;
+using Record = std::tuple<int64_t, double, char>;
+
+Record make_record(int i) {
+  return Record(i, i * 0.5, static_cast<char>('a' + i % 26));
+}
+
+bool same(const Records& deque, const std::deque<Record>& expected) {
+  if (deque.size() != expected.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (Record(deque[i]) != expected[i] or
+        deque.get<0>(i) != std::get<0>(expected[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_against_std_deque() {
+  Records deque;
+  std::deque<Record> expected;
+  std::mt19937 random(3);
+  for (int step = 0; step < 200000; ++step) {
+    Record record = make_record(step);
+    switch (random() % 5) {
+      case 0:
+      case 1:
+        deque.push_back(std::get<0>(record), std::get<1>(record),
+                        std::get<2>(record));
+        expected.push_back(record);
+        break;
+      case 2:
+        deque.push_front(std::get<0>(record), std::get<1>(record),
+                         std::get<2>(record));
+        expected.push_front(record);
+        break;
+      case 3:
+        if (!expected.empty()) {
+          deque.pop_back();
+          expected.pop_back();
+        }
+        break;
+      default:
+        if (!expected.empty()) {
+          deque.pop_front();
+          expected.pop_front();
+        }
+    }
+    if (step % 10000 == 0) {
+      CHECK(same(deque, expected));
+    }
+  }
+  CHECK(same(deque, expected));
+  deque.clear();
+  CHECK(deque.empty() and deque.begin() == deque.end());
+}
+
+void test_rows_and_iterators() {
+  Records deque;
+  for (int i = 0; i < 5000; ++i) {
+    deque.push_front(i, 0.0, 'x');
+  }
+  deque[10].get<1>() = 2.5;
+  deque.get<2>(11) = 'y';
+  CHECK(deque.get<1>(10) == 2.5 and deque[11].get<2>() == 'y');
+  int64_t expected = 4999;
+  for (auto row : deque) {
+    CHECK(row.get<0>() == expected--);
+  }
+  CHECK(expected == -1);
+  Records::iterator middle = deque.begin() + 2500;
+  CHECK((*middle).get<0>() == 2499 and middle[1].get<0>() == 2498);
+  CHECK(deque.end() - middle == 2500 and middle < deque.end());
+  Records::const_iterator first = deque.begin();
+  CHECK(first == deque.cbegin() and (*--middle).get<0>() == 2500);
+}
+
+void test_column_spans() {
+  Records deque;
+  for (int i = 0; i < 3000; ++i) {
+    deque.push_back(i, 1.0, 'z');
+  }
+  for (int i = 0; i < 700; ++i) {
+    deque.pop_front();
+  }
+  int64_t sum = 0;
+  size_t spans = 0;
+  int64_t next = 700;
+  deque.for_each_span<0>([&](const int64_t* first, const int64_t* last) {
+    spans++;
+    for (; first != last; ++first) {
+      CHECK(*first == next++);
+      sum += *first;
+    }
+  });
+  CHECK(next == 3000 and spans > 1);
+  CHECK(sum == (700 + 2999) * int64_t{2300} / 2);
+  double total = 0;
+  const Records& view = deque;
+  view.for_each_span<1>([&total](const double* first, const double* last) {
+    for (; first != last; ++first) {
+      total += *first;
+    }
+  });
+  CHECK(total == 2300.0);
+}
+
+void test_copy_and_move() {
+  Records deque;
+  std::deque<Record> expected;
+  for (int i = 0; i < 2000; ++i) {
+    deque.push_front(i, i * 0.5, 'c');
+    expected.push_front(Record(i, i * 0.5, 'c'));
+  }
+  Records copy(deque);
+  CHECK(same(copy, expected));
+  Records moved(std::move(copy));
+  CHECK(same(moved, expected) and copy.empty());
+  Records assigned;
+  assigned.push_back(1, 1.0, '1');
+  assigned = deque;
+  CHECK(same(assigned, expected));
+  assigned.pop_back();
+  deque = std::move(assigned);
+  expected.pop_back();
+  CHECK(same(deque, expected));
+}
+
+}  // namespace
+
+int main() {
+  test_against_std_deque();
+  test_rows_and_iterators();
+  test_column_spans();
+  test_copy_and_move();
+  std::puts("ok");
+}
@@ -0,0 +1,116 @@
+// Behaviour of SpscDeque: FIFO order across blocks, move-only elements,
+// block recycling and a two-thread transfer. Build with -pthread; worth
+// running under -fsanitize=thread as well.
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "../spsc_deque.h"
+#include "check.h"
+
+namespace {
+
+size_t live_blocks = 0;
+size_t block_allocations = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    live_blocks++;
+    block_allocations++;
+    return std::allocator<T>().allocate(count);
+  }
+  void deallocate(T* pointer, size_t count) {
+    live_blocks--;
+    std::allocator<T>().deallocate(pointer, count);
+  }
+
+  bool operator==(const CountingAllocator&) const { return true; }
+  bool operator!=(const CountingAllocator&) const { return false; }
+};
+
+void test_fifo() {
+  SpscDeque<int> queue;
+  int value = -1;
+  CHECK(queue.empty() and !queue.try_pop_front(value) and value == -1);
+  for (int i = 0; i < 10000; ++i) {
+    queue.push_back(i);
+  }
+  CHECK(queue.size() == 10000);
+  for (int i = 0; i < 10000; ++i) {
+    CHECK(queue.try_pop_front(value) and value == i);
+  }
+  CHECK(queue.empty() and !queue.try_pop_front(value));
+}
+
+void test_move_only() {
+  SpscDeque<std::unique_ptr<int>> queue;
+  for (int i = 0; i < 3000; ++i) {
+    queue.emplace_back(new int(i));
+  }
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(queue.try_pop_front(value) and *value == i);
+  }
+  // The remaining 2000 are freed by the destructor; -fsanitize=address
+  // reports a leak otherwise.
+}
+
+void test_recycling() {
+  {
+    SpscDeque<int, CountingAllocator<int>> queue;
+    int value;
+    for (int round = 0; round < 1000; ++round) {
+      for (int i = 0; i < 2000; ++i) {
+        queue.push_back(i);
+      }
+      for (int i = 0; i < 2000; ++i) {
+        CHECK(queue.try_pop_front(value) and value == i);
+      }
+    }
+    // 2000 ints span a handful of blocks; drained ones are reused
+    // instead of allocated again every round.
+    CHECK(block_allocations < 16);
+  }
+  CHECK(live_blocks == 0);
+}
+
+void test_two_threads() {
+  constexpr long long kElements = 2000000;
+  SpscDeque<long long> queue;
+  std::thread producer([&queue] {
+    for (long long i = 0; i < kElements; ++i) {
+      queue.push_back(i);
+    }
+  });
+  long long expected = 0;
+  long long value;
+  while (expected < kElements) {
+    if (queue.try_pop_front(value)) {
+      CHECK(value == expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  CHECK(queue.empty());
+}
+
+}  // namespace
+
+int main() {
+  test_fifo();
+  test_move_only();
+  test_recycling();
+  test_two_threads();
+  std::puts("ok");
+}
@@ -0,0 +1,165 @@
+// Behaviour of StackStorage reclamation: LIFO rollback of the top block,
+// size-class free lists, alignment of reused blocks, reset(), and a list
+// used as a queue running far past the arena size without running out.
+// Also the concurrent arena and the per-thread arenas. Build with -pthread.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "../stackallocator.h"
+#include "check.h"
+
+namespace {
+
+void test_lifo_rollback() {
+  StackStorage<1024> storage;
+  void* first = storage.allocate(24, 8);
+  void* second = storage.allocate(100, 8);
+  size_t top = storage.last_used_.load();
+  storage.deallocate(second, 100);
+  CHECK(storage.last_used_.load() == top - 104);
+  CHECK(storage.allocate(100, 8) == second);
+  storage.deallocate(second, 100);
+  storage.deallocate(first, 24);
+  CHECK(storage.last_used_.load() == 0);
+}
+
+void test_free_lists() {
+  StackStorage<1024> storage;
+  void* first = storage.allocate(32, 8);
+  void* second = storage.allocate(32, 8);
+  void* third = storage.allocate(48, 8);
+  size_t top = storage.last_used_.load();
+  storage.deallocate(first, 32);
+  storage.deallocate(second, 32);
+  CHECK(storage.last_used_.load() == top);
+  // Most recently freed first; other size classes do not see them.
+  CHECK(storage.allocate(48, 8) != first);
+  CHECK(storage.allocate(30, 8) == second);
+  CHECK(storage.allocate(32, 8) == first);
+  storage.deallocate(third, 48);
+  void* fourth = storage.allocate(48, 8);
+  CHECK(fourth == third);
+}
+
+void test_alignment() {
+  StackStorage<1024> storage;
+  void* pad = storage.allocate(8, 8);
+  void* block = storage.allocate(64, 8);
+  void* guard = storage.allocate(8, 8);
+  storage.deallocate(block, 64);
+  bool block_aligned = reinterpret_cast<uintptr_t>(block) % 64 == 0;
+  void* aligned = storage.allocate(64, 64);
+  CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+  CHECK((aligned == block) == block_aligned);
+  storage.deallocate(pad, 8);
+  storage.deallocate(guard, 8);
+}
+
+void test_reset_and_exhaustion() {
+  StackStorage<256> storage;
+  storage.allocate(200, 8);
+  bool threw = false;
+  try {
+    storage.allocate(100, 8);
+  } catch (const std::bad_alloc&) {
+    threw = true;
+  }
+  CHECK(threw);
+  storage.reset();
+  CHECK(storage.last_used_.load() == 0);
+  storage.allocate(250, 8);
+}
+
+void test_queue_in_bounded_arena() {
+  constexpr size_t kArenaBytes = 4096;
+  StackStorage<kArenaBytes> storage;
+  StackAllocator<int, kArenaBytes> alloc(storage);
+  List<int, StackAllocator<int, kArenaBytes>> queue(alloc);
+  // About 3 MB of node traffic through a 4 KB arena.
+  for (int i = 0; i < 100000; ++i) {
+    queue.push_back(i);
+    if (queue.size() > 50) {
+      CHECK(*queue.begin() == i - 50);
+      queue.pop_front();
+    }
+  }
+  CHECK(queue.size() == 50);
+  CHECK(storage.last_used_.load() <= 51 * 32);
+}
+
+void test_concurrent_arena() {
+  constexpr size_t kArenaBytes = 1 << 16;
+  constexpr int kThreads = 4;
+  constexpr int kBlocks = 5000;
+  StackStorage<kArenaBytes, NoArenaStats, ConcurrentArena> storage(
+      std::pmr::new_delete_resource());
+  std::vector<std::vector<unsigned char*>> blocks(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&storage, &blocks, t] {
+      for (int i = 0; i < kBlocks; ++i) {
+        size_t alignment = (i % 3 == 0 ? 64 : 8);
+        auto* block =
+            static_cast<unsigned char*>(storage.allocate(40, alignment));
+        CHECK(reinterpret_cast<uintptr_t>(block) % alignment == 0);
+        std::fill(block, block + 40, static_cast<unsigned char>(t + 1));
+        blocks[t].push_back(block);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // The blocks overflow into upstream chunks, and none of them overlap:
+  // every byte still holds the value its own thread wrote.
+  CHECK(storage.chunks_.load() != nullptr);
+  for (int t = 0; t < kThreads; ++t) {
+    for (unsigned char* block : blocks[t]) {
+      for (int i = 0; i < 40; ++i) {
+        CHECK(block[i] == t + 1);
+      }
+    }
+  }
+}
+
+void test_per_thread_arenas() {
+  constexpr size_t kArenaBytes = 4096;
+  using Alloc = StackAllocator<int, kArenaBytes>;
+  StackStorage<kArenaBytes>* main_arena =
+      &StackStorage<kArenaBytes>::for_this_thread();
+  CHECK(main_arena == &StackStorage<kArenaBytes>::for_this_thread());
+  CHECK(Alloc::for_this_thread().storage_ == main_arena);
+  CHECK(Alloc().storage_ == nullptr);
+  StackStorage<kArenaBytes>* other_arena = nullptr;
+  std::thread other([&other_arena] {
+    other_arena = &StackStorage<kArenaBytes>::for_this_thread();
+    List<int, Alloc> list(Alloc::for_this_thread());
+    // Past the inline bytes the arena carries on from operator new.
+    for (int i = 0; i < 1000; ++i) {
+      list.push_back(i);
+    }
+    CHECK(list.size() == 1000 and *list.rbegin() == 999);
+  });
+  other.join();
+  CHECK(other_arena != nullptr and other_arena != main_arena);
+}
+
+}  // namespace
+
+int main() {
+  test_lifo_rollback();
+  test_free_lists();
+  test_alignment();
+  test_reset_and_exhaustion();
+  test_queue_in_bounded_arena();
+  test_concurrent_arena();
+  test_per_thread_arenas();
+  std::puts("ok");
+}
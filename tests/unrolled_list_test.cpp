@@ -0,0 +1,202 @@
+// Behaviour of UnrolledList: random inserts and erases checked against
+// std::list, node occupancy after splits and merges, splice between equal
+// and unequal allocators, copies and moves, and that every element is
+// destroyed exactly once.
+
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../stackallocator.h"
+#include "../unrolled_list.h"
+#include "check.h"
+
+namespace {
+
+int live = 0;
+size_t live_nodes = 0;
+
+struct Tracked {
+  Tracked(int value) : value(value) { live++; }
+  Tracked(const Tracked& other) : value(other.value) { live++; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() { live--; }
+
+  int value;
+};
+
+template <typename T>
+struct NodeCountingAllocator {
+  using value_type = T;
+
+  NodeCountingAllocator() = default;
+  template <typename U>
+  NodeCountingAllocator(const NodeCountingAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    live_nodes += count;
+    return std::allocator<T>().allocate(count);
+  }
+  void deallocate(T* pointer, size_t count) {
+    live_nodes -= count;
+    std::allocator<T>().deallocate(pointer, count);
+  }
+
+  bool operator==(const NodeCountingAllocator&) const { return true; }
+  bool operator!=(const NodeCountingAllocator&) const { return false; }
+};
+
+template <typename List>
+bool same(const List& list, const std::list<int>& expected) {
+  if (list.size() != expected.size()) {
+    return false;
+  }
+  auto it = expected.begin();
+  for (const auto& element : list) {
+    if (element.value != *it++) {
+      return false;
+    }
+  }
+  auto rit = expected.rbegin();
+  for (auto element = list.rbegin(); element != list.rend(); ++element) {
+    if (element->value != *rit++) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_against_std_list() {
+  constexpr size_t kNode = 8;
+  {
+    UnrolledList<Tracked, kNode, NodeCountingAllocator<Tracked>> list;
+    std::list<int> expected;
+    std::mt19937 random(13);
+    for (int step = 0; step < 100000; ++step) {
+      int value = static_cast<int>(random() % 1000);
+      size_t position = (expected.empty() ? 0 : random() % expected.size());
+      auto it = std::next(list.begin(), position);
+      auto expected_it = std::next(expected.begin(), position);
+      switch (random() % 6) {
+        case 0:
+          list.push_back(value);
+          expected.push_back(value);
+          break;
+        case 1:
+          list.emplace_front(value);
+          expected.push_front(value);
+          break;
+        case 2:
+        case 3:
+          CHECK(list.insert(it, Tracked(value))->value == value);
+          expected.insert(expected_it, value);
+          break;
+        default:
+          if (!expected.empty()) {
+            auto next = list.erase(it);
+            auto expected_next = expected.erase(expected_it);
+            CHECK(next == list.end() or next->value == *expected_next);
+          }
+      }
+      if (expected.size() > 2000) {
+        list.pop_front();
+        list.pop_back();
+        expected.pop_front();
+        expected.pop_back();
+      }
+      CHECK(live == static_cast<int>(expected.size()));
+      if (step % 5000 == 0) {
+        CHECK(same(list, expected));
+        // Merges keep nodes more than half full apart from a few.
+        CHECK(live_nodes <= expected.size() * 2 / kNode + 8);
+      }
+    }
+    CHECK(same(list, expected));
+    list.clear();
+    CHECK(list.empty() and live_nodes == 0);
+  }
+  CHECK(live == 0);
+}
+
+template <typename List>
+std::vector<int> contents(const List& list) {
+  return std::vector<int>(list.begin(), list.end());
+}
+
+void test_splice() {
+  UnrolledList<int, 4> list;
+  UnrolledList<int, 4> other;
+  for (int i = 0; i < 10; ++i) {
+    list.push_back(i);
+    other.push_back(100 + i);
+  }
+  int* kept = &*std::next(other.begin(), 5);
+  list.splice(std::next(list.begin(), 3), other);
+  CHECK(other.empty() and list.size() == 20);
+  CHECK(&*std::next(list.begin(), 8) == kept);
+  std::vector<int> expected = {0, 1, 2};
+  for (int i = 0; i < 10; ++i) {
+    expected.push_back(100 + i);
+  }
+  for (int i = 3; i < 10; ++i) {
+    expected.push_back(i);
+  }
+  CHECK(contents(list) == expected);
+
+  constexpr size_t kArenaBytes = 1 << 14;
+  StackStorage<kArenaBytes> first_storage;
+  StackStorage<kArenaBytes> second_storage;
+  using Alloc = StackAllocator<int, kArenaBytes>;
+  UnrolledList<int, 4, Alloc> first{Alloc(first_storage)};
+  UnrolledList<int, 4, Alloc> second{Alloc(second_storage)};
+  for (int i = 0; i < 6; ++i) {
+    first.push_back(i);
+    second.push_back(10 + i);
+  }
+  first.splice(first.end(), std::move(second));
+  CHECK(second.empty());
+  CHECK((contents(first) ==
+         std::vector<int>{0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15}));
+}
+
+void test_copy_and_move() {
+  {
+    UnrolledList<Tracked, 4> list;
+    std::list<int> expected;
+    for (int i = 0; i < 50; ++i) {
+      list.emplace_back(i);
+      expected.push_back(i);
+    }
+    UnrolledList<Tracked, 4> copy(list);
+    CHECK(same(copy, expected) and live == 100);
+    UnrolledList<Tracked, 4> moved(std::move(copy));
+    CHECK(same(moved, expected) and copy.empty());
+    UnrolledList<Tracked, 4> assigned;
+    assigned.emplace_back(-1);
+    assigned = list;
+    CHECK(same(assigned, expected));
+    assigned.pop_front();
+    list = std::move(assigned);
+    expected.pop_front();
+    CHECK(same(list, expected));
+  }
+  CHECK(live == 0);
+  UnrolledList<int> sized(10, 7);
+  CHECK(sized.size() == 10 and *sized.rbegin() == 7);
+}
+
+}  // namespace
+
+int main() {
+  test_against_std_list();
+  test_splice();
+  test_copy_and_move();
+  std::puts("ok");
+}
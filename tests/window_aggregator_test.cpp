@@ -0,0 +1,104 @@
+// Behaviour of WindowAggregator: sum, min, max and a non-commutative op
+// checked against a full rescan of the window after every step, plus
+// batched ingest and time-based expiry.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../window_aggregator.h"
+#include "check.h"
+
+namespace {
+
+// Keeps only the last few characters so that the fold stays cheap but
+// still depends on the order of its operands.
+struct Concatenate {
+  std::string operator()(const std::string& lhs,
+                         const std::string& rhs) const {
+    std::string result = lhs + rhs;
+    return result.size() > 8 ? result.substr(result.size() - 8) : result;
+  }
+};
+
+template <typename T, typename Op>
+T rescan(const std::deque<T>& window, Op op) {
+  T result = window[0];
+  for (size_t i = 1; i < window.size(); ++i) {
+    result = op(result, window[i]);
+  }
+  return result;
+}
+
+template <typename T, typename Op, typename Make>
+void check_against_rescan(Op op, Make make) {
+  WindowAggregator<T, Op> aggregator;
+  std::deque<T> window;
+  std::mt19937 random(11);
+  for (int step = 0; step < 20000; ++step) {
+    if (window.empty() or (window.size() < 500 and random() % 2 == 0)) {
+      T value = make(static_cast<int>(random() % 1000));
+      aggregator.push(value);
+      window.push_back(value);
+    } else {
+      aggregator.evict();
+      window.pop_front();
+    }
+    CHECK(aggregator.size() == window.size());
+    if (!window.empty()) {
+      CHECK(aggregator.query() == rescan(window, op));
+    }
+  }
+}
+
+void test_ops() {
+  auto number = [](int value) { return static_cast<long long>(value); };
+  check_against_rescan<long long>(std::plus<long long>(), number);
+  check_against_rescan<long long>(WindowMin(), number);
+  check_against_rescan<long long>(WindowMax(), number);
+  check_against_rescan<std::string>(Concatenate(), [](int value) {
+    return std::string(1, static_cast<char>('a' + value % 26));
+  });
+}
+
+void test_batches_and_expiry() {
+  WindowAggregator<int> sum;
+  WindowAggregator<int, WindowMax> max;
+  std::vector<int> batch = {5, 1, 4};
+  sum.push_range(batch.begin(), batch.end(), 10);
+  max.push_range(batch.begin(), batch.end(), 10);
+  sum.push(7, 20);
+  max.push(2, 20);
+  sum.push(3, 30);
+  max.push(3, 30);
+  CHECK(sum.size() == 5 and sum.query() == 20);
+  CHECK(max.size() == 5 and max.query() == 5);
+  sum.expire_before(10);
+  max.expire_before(10);
+  CHECK(sum.size() == 5 and max.size() == 5);
+  sum.expire_before(11);
+  max.expire_before(11);
+  CHECK(sum.size() == 2 and sum.query() == 10);
+  CHECK(max.size() == 2 and max.query() == 3);
+  sum.evict(1);
+  max.evict(1);
+  CHECK(sum.query() == 3 and max.query() == 3);
+  sum.expire_before(100);
+  max.expire_before(100);
+  CHECK(sum.empty() and max.empty());
+  sum.push(9, 200);
+  CHECK(sum.query() == 9);
+}
+
+}  // namespace
+
+int main() {
+  test_ops();
+  test_batches_and_expiry();
+  std::puts("ok");
+}
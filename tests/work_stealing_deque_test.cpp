@@ -0,0 +1,110 @@
+// Behaviour of WorkStealingDeque and WorkStealingExecutor: owner LIFO and
+// thief FIFO order, growth past the initial ring, every element taken
+// exactly once under concurrent steals, and fork-join on the executor.
+// Build with -pthread. ThreadSanitizer does not model the fences the deque
+// relies on, so it is not a useful check here.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../work_stealing_deque.h"
+#include "../work_stealing_executor.h"
+#include "check.h"
+
+namespace {
+
+void test_single_thread() {
+  WorkStealingDeque<int> deque;
+  int value = -1;
+  CHECK(deque.empty() and !deque.try_pop_back(value) and
+        !deque.try_steal(value));
+  for (int i = 0; i < 100000; ++i) {
+    deque.push_back(i);
+  }
+  CHECK(deque.size() == 100000);
+  CHECK(deque.try_steal(value) and value == 0);
+  CHECK(deque.try_steal(value) and value == 1);
+  CHECK(deque.try_pop_back(value) and value == 99999);
+  for (int i = 99998; i >= 2; --i) {
+    CHECK(deque.try_pop_back(value) and value == i);
+  }
+  CHECK(deque.empty() and !deque.try_pop_back(value) and
+        !deque.try_steal(value));
+  deque.push_back(7);
+  CHECK(deque.try_steal(value) and value == 7);
+}
+
+void test_concurrent_steals() {
+  constexpr int kElements = 200000;
+  constexpr int kThieves = 3;
+  WorkStealingDeque<int> deque;
+  std::vector<std::atomic<int>> taken(kElements);
+  std::atomic<bool> done{false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThieves; ++i) {
+    thieves.emplace_back([&] {
+      int value;
+      while (!done.load() or !deque.empty()) {
+        if (deque.try_steal(value)) {
+          taken[value]++;
+        }
+      }
+    });
+  }
+  int value;
+  for (int i = 0; i < kElements; ++i) {
+    deque.push_back(i);
+    if (i % 3 == 0 and deque.try_pop_back(value)) {
+      taken[value]++;
+    }
+  }
+  while (deque.try_pop_back(value)) {
+    taken[value]++;
+  }
+  done = true;
+  for (std::thread& thief : thieves) {
+    thief.join();
+  }
+  for (int i = 0; i < kElements; ++i) {
+    CHECK(taken[i].load() == 1);
+  }
+}
+
+long long fib(WorkStealingExecutor& executor, int n) {
+  if (n < 12) {
+    return n < 2 ? n : fib(executor, n - 1) + fib(executor, n - 2);
+  }
+  long long left = 0;
+  long long right = 0;
+  TaskGroup group(executor);
+  group.run([&executor, &left, n] { left = fib(executor, n - 1); });
+  right = fib(executor, n - 2);
+  group.wait();
+  return left + right;
+}
+
+void test_executor() {
+  WorkStealingExecutor executor(4);
+  CHECK(executor.workers() == 4);
+  CHECK(fib(executor, 25) == 75025);
+  std::atomic<int> runs{0};
+  {
+    TaskGroup group(executor);
+    for (int i = 0; i < 1000; ++i) {
+      group.run([&runs] { runs++; });
+    }
+  }
+  CHECK(runs.load() == 1000);
+}
+
+}  // namespace
+
+int main() {
+  test_single_thread();
+  test_concurrent_steals();
+  test_executor();
+  std::puts("ok");
+}
@@ -0,0 +1,520 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Node size that keeps an UnrolledList node around four cache lines.
+template <typename T>
+inline constexpr size_t kUnrolledListNodeElements =
+    std::max<size_t>(256 / sizeof(T), 4);
+
+// Doubly linked list of nodes that each hold up to K elements in an inline
+// array, with the same interface as List. Traversal touches one node per K
+// elements instead of one per element, and the list pays two pointers per
+// node instead of per element.
+//
+// Elements are packed at the start of their node. Inserting into a full
+// node splits it in half; an erase that leaves a node less than half full
+// merges it with a neighbour when the two fit in one node, so occupancy
+// stays above one half except for a few nodes. Pushes at either end open a
+// new node when the end node is full, so a list built by pushes is packed.
+// Operations inside a node shift up to K elements; every insert and erase
+// may invalidate iterators to the elements of the nodes involved.
+template <typename T, size_t K = kUnrolledListNodeElements<T>,
+          typename Allocator = std::allocator<T>>
+class UnrolledList {
+  static_assert(K >= 2, "UnrolledList nodes need room for two elements");
+
+ private:
+  struct BaseNode {
+    BaseNode* prev = nullptr;
+    BaseNode* next = nullptr;
+    size_t count = 0;
+  };
+
+  struct Node : BaseNode {
+    alignas(T) unsigned char storage[K * sizeof(T)];
+
+    T* data() { return reinterpret_cast<T*>(storage); }
+  };
+
+  using NodeAlloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using AllocTraits = std::allocator_traits<NodeAlloc>;
+
+ public:
+  UnrolledList() = default;
+  UnrolledList(size_t size, const Allocator& alloc = Allocator());
+  UnrolledList(size_t size, const T& value,
+               const Allocator& alloc = Allocator());
+  UnrolledList(const Allocator& alloc) : alloc_(alloc) {}
+  UnrolledList(const UnrolledList& list);
+  UnrolledList(UnrolledList&& list) noexcept;
+  UnrolledList& operator=(const UnrolledList& list);
+  UnrolledList& operator=(UnrolledList&& list) noexcept(
+      AllocTraits::propagate_on_container_move_assignment::value ||
+      AllocTraits::is_always_equal::value);
+  ~UnrolledList() { clear(); }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  void pop_back();
+  void pop_front();
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+  template <typename... Args>
+  T& emplace_front(Args&&... args);
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  NodeAlloc get_allocator() const { return alloc_; }
+
+  template <bool is_const>
+  class common_iterator;
+
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  iterator begin() { return iterator(sentinel_.next, 0); }
+  iterator end() { return iterator(&sentinel_, 0); }
+  const_iterator begin() const { return const_iterator(sentinel_.next, 0); }
+  const_iterator end() const { return const_iterator(sentinel(), 0); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return std::make_reverse_iterator(end()); }
+  reverse_iterator rend() { return std::make_reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const {
+    return std::make_reverse_iterator(cend());
+  }
+  const_reverse_iterator rend() const {
+    return std::make_reverse_iterator(cbegin());
+  }
+  const_reverse_iterator crbegin() const {
+    return std::make_reverse_iterator(cend());
+  }
+  const_reverse_iterator crend() const {
+    return std::make_reverse_iterator(cbegin());
+  }
+
+  iterator insert(const_iterator it, const T& element) {
+    return emplace(it, element);
+  }
+  iterator insert(const_iterator it, T&& element) {
+    return emplace(it, std::move(element));
+  }
+  template <typename... Args>
+  iterator emplace(const_iterator it, Args&&... args);
+
+  // Returns the iterator following the erased element.
+  iterator erase(const_iterator it);
+
+  // Moves every element of `list` before `it` by relinking its nodes; only
+  // the node `it` points into may be split. If the allocators differ, the
+  // elements are moved one by one into nodes from this list's allocator.
+  void splice(const_iterator it, UnrolledList& list);
+  void splice(const_iterator it, UnrolledList&& list) { splice(it, list); }
+
+  void clear();
+
+ private:
+  // Circular: the sentinel links the last node to the first one and acts as
+  // end(); its count stays 0.
+  BaseNode sentinel_{&sentinel_, &sentinel_, 0};
+  size_t size_ = 0;
+  NodeAlloc alloc_;
+
+  BaseNode* sentinel() const { return const_cast<BaseNode*>(&sentinel_); }
+  static Node* as_node(BaseNode* node) { return static_cast<Node*>(node); }
+
+  Node* create_node_after(BaseNode* where);
+  void destroy_node(BaseNode* node);
+  // Moves elements [from, node->count) of `node` to the end of `to`.
+  void move_tail(Node* node, size_t from, Node* to);
+  // Opens a hole at (node, index), splitting a full node first; both are
+  // updated to where the hole ended up.
+  void make_room(Node*& node, size_t& index);
+  void steal_nodes(UnrolledList& list);
+  void swap_lists(UnrolledList& list);
+};
+
+template <typename T, size_t K, typename Allocator>
+template <bool is_const>
+class UnrolledList<T, K, Allocator>::common_iterator {
+ public:
+  using value_type = std::conditional_t<is_const, const T, T>;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using difference_type = long long;
+
+  common_iterator() = default;
+  common_iterator(BaseNode* node, size_t index) : node_(node), index_(index) {}
+
+  operator const_iterator() const { return const_iterator(node_, index_); }
+
+  reference operator*() const { return as_node(node_)->data()[index_]; }
+  pointer operator->() const { return as_node(node_)->data() + index_; }
+
+  common_iterator& operator++() {
+    if (++index_ == node_->count) {
+      node_ = node_->next;
+      index_ = 0;
+    }
+    return *this;
+  }
+  common_iterator operator++(int) {
+    auto it = *this;
+    ++*this;
+    return it;
+  }
+  common_iterator& operator--() {
+    if (index_ == 0) {
+      node_ = node_->prev;
+      index_ = node_->count;
+    }
+    --index_;
+    return *this;
+  }
+  common_iterator operator--(int) {
+    auto it = *this;
+    --*this;
+    return it;
+  }
+
+  bool operator==(const common_iterator& it) const {
+    return node_ == it.node_ and index_ == it.index_;
+  }
+  bool operator!=(const common_iterator& it) const { return !((*this) == it); }
+
+ private:
+  friend class UnrolledList;
+
+  BaseNode* node_ = nullptr;
+  size_t index_ = 0;
+};
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>::UnrolledList(size_t size,
+                                            const Allocator& alloc)
+    : alloc_(alloc) {
+  try {
+    while (size_ != size) {
+      emplace_back();
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>::UnrolledList(size_t size, const T& value,
+                                            const Allocator& alloc)
+    : alloc_(alloc) {
+  try {
+    while (size_ != size) {
+      emplace_back(value);
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>::UnrolledList(const UnrolledList& list)
+    : alloc_(AllocTraits::select_on_container_copy_construction(list.alloc_)) {
+  try {
+    for (const T& value : list) {
+      emplace_back(value);
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>::UnrolledList(UnrolledList&& list) noexcept
+    : alloc_(std::move(list.alloc_)) {
+  steal_nodes(list);
+}
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>& UnrolledList<T, K, Allocator>::operator=(
+    const UnrolledList& list) {
+  UnrolledList temporary(
+      AllocTraits::propagate_on_container_copy_assignment::value ? list.alloc_
+                                                                 : alloc_);
+  for (const T& value : list) {
+    temporary.emplace_back(value);
+  }
+  swap_lists(temporary);
+  return *this;
+}
+
+template <typename T, size_t K, typename Allocator>
+UnrolledList<T, K, Allocator>& UnrolledList<T, K, Allocator>::operator=(
+    UnrolledList&& list) noexcept(AllocTraits::
+                                      propagate_on_container_move_assignment::
+                                          value ||
+                                  AllocTraits::is_always_equal::value) {
+  if (AllocTraits::propagate_on_container_move_assignment::value ||
+      alloc_ == list.alloc_) {
+    UnrolledList temporary(std::move(list));
+    if (!AllocTraits::propagate_on_container_move_assignment::value) {
+      temporary.alloc_ = alloc_;
+    }
+    swap_lists(temporary);
+  } else {
+    UnrolledList temporary(alloc_);
+    for (T& value : list) {
+      temporary.emplace_back(std::move(value));
+    }
+    swap_lists(temporary);
+  }
+  return *this;
+}
+
+template <typename T, size_t K, typename Allocator>
+typename UnrolledList<T, K, Allocator>::Node*
+UnrolledList<T, K, Allocator>::create_node_after(BaseNode* where) {
+  Node* node = AllocTraits::allocate(alloc_, 1);
+  AllocTraits::construct(alloc_, node);
+  node->prev = where;
+  node->next = where->next;
+  where->next->prev = node;
+  where->next = node;
+  return node;
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::destroy_node(BaseNode* node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  AllocTraits::destroy(alloc_, as_node(node));
+  AllocTraits::deallocate(alloc_, as_node(node), 1);
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::move_tail(Node* node, size_t from,
+                                              Node* to) {
+  T* source = node->data();
+  T* target = to->data();
+  for (size_t i = from; i < node->count; i++) {
+    AllocTraits::construct(alloc_, target + to->count, std::move(source[i]));
+    AllocTraits::destroy(alloc_, source + i);
+    to->count++;
+  }
+  node->count = from;
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::make_room(Node*& node, size_t& index) {
+  if (node->count == K) {
+    Node* right = create_node_after(node);
+    move_tail(node, K / 2, right);
+    if (index > K / 2) {
+      node = right;
+      index -= K / 2;
+    }
+  }
+  T* data = node->data();
+  for (size_t i = node->count; i > index; i--) {
+    AllocTraits::construct(alloc_, data + i, std::move(data[i - 1]));
+    AllocTraits::destroy(alloc_, data + i - 1);
+  }
+}
+
+template <typename T, size_t K, typename Allocator>
+template <typename... Args>
+T& UnrolledList<T, K, Allocator>::emplace_back(Args&&... args) {
+  return *emplace(end(), std::forward<Args>(args)...);
+}
+
+template <typename T, size_t K, typename Allocator>
+template <typename... Args>
+T& UnrolledList<T, K, Allocator>::emplace_front(Args&&... args) {
+  if (sentinel_.next->count == K) {
+    // A full first node gets a new neighbour instead of being split, so
+    // that repeated push_front keeps nodes full.
+    Node* node = create_node_after(&sentinel_);
+    try {
+      AllocTraits::construct(alloc_, node->data(),
+                             std::forward<Args>(args)...);
+    } catch (...) {
+      destroy_node(node);
+      throw;
+    }
+    node->count = 1;
+    size_++;
+    return node->data()[0];
+  }
+  return *emplace(begin(), std::forward<Args>(args)...);
+}
+
+template <typename T, size_t K, typename Allocator>
+template <typename... Args>
+typename UnrolledList<T, K, Allocator>::iterator
+UnrolledList<T, K, Allocator>::emplace(const_iterator it, Args&&... args) {
+  BaseNode* base = it.node_;
+  size_t index = it.index_;
+  // An insert before the first element of a node goes to the end of the
+  // previous node when that one has room: no shifting, and it covers end().
+  if (index == 0 and base->prev != &sentinel_ and base->prev->count < K) {
+    base = base->prev;
+    index = base->count;
+  }
+  if (base == &sentinel_) {
+    base = create_node_after(sentinel_.prev);
+    try {
+      AllocTraits::construct(alloc_, as_node(base)->data(),
+                             std::forward<Args>(args)...);
+    } catch (...) {
+      destroy_node(base);
+      throw;
+    }
+    base->count = 1;
+    size_++;
+    return iterator(base, 0);
+  }
+  Node* node = as_node(base);
+  if (index == node->count and index < K) {
+    AllocTraits::construct(alloc_, node->data() + index,
+                           std::forward<Args>(args)...);
+  } else {
+    // Built before shifting, so a throwing constructor leaves no hole.
+    T value(std::forward<Args>(args)...);
+    make_room(node, index);
+    AllocTraits::construct(alloc_, node->data() + index, std::move(value));
+  }
+  node->count++;
+  size_++;
+  return iterator(node, index);
+}
+
+template <typename T, size_t K, typename Allocator>
+typename UnrolledList<T, K, Allocator>::iterator
+UnrolledList<T, K, Allocator>::erase(const_iterator it) {
+  Node* node = as_node(it.node_);
+  size_t index = it.index_;
+  T* data = node->data();
+  AllocTraits::destroy(alloc_, data + index);
+  for (size_t i = index + 1; i < node->count; i++) {
+    AllocTraits::construct(alloc_, data + i - 1, std::move(data[i]));
+    AllocTraits::destroy(alloc_, data + i);
+  }
+  node->count--;
+  size_--;
+
+  if (node->count == 0) {
+    BaseNode* next = node->next;
+    destroy_node(node);
+    return iterator(next, 0);
+  }
+  if (node->count < K / 2) {
+    BaseNode* prev = node->prev;
+    BaseNode* next = node->next;
+    if (prev != &sentinel_ and prev->count + node->count <= K) {
+      index += prev->count;
+      move_tail(node, 0, as_node(prev));
+      destroy_node(node);
+      node = as_node(prev);
+    } else if (next != &sentinel_ and node->count + next->count <= K) {
+      move_tail(as_node(next), 0, node);
+      destroy_node(next);
+    }
+  }
+  if (index == node->count) {
+    return iterator(node->next, 0);
+  }
+  return iterator(node, index);
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::pop_back() {
+  erase(std::prev(end()));
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::pop_front() {
+  erase(begin());
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::splice(const_iterator it,
+                                           UnrolledList& list) {
+  if (list.size_ == 0 or &list == this) {
+    return;
+  }
+  if (!(alloc_ == list.alloc_)) {
+    iterator position = emplace(it, std::move(*list.begin()));
+    for (auto element = std::next(list.begin()); element != list.end();
+         ++element) {
+      position = emplace(std::next(position), std::move(*element));
+    }
+    list.clear();
+    return;
+  }
+  BaseNode* before = it.node_;
+  if (it.index_ != 0) {
+    Node* right = create_node_after(it.node_);
+    move_tail(as_node(it.node_), it.index_, right);
+    before = right;
+  }
+  BaseNode* first = list.sentinel_.next;
+  BaseNode* last = list.sentinel_.prev;
+  first->prev = before->prev;
+  before->prev->next = first;
+  last->next = before;
+  before->prev = last;
+  size_ += list.size_;
+  list.sentinel_.next = list.sentinel_.prev = &list.sentinel_;
+  list.size_ = 0;
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::clear() {
+  while (sentinel_.next != &sentinel_) {
+    Node* node = as_node(sentinel_.next);
+    T* data = node->data();
+    for (size_t i = 0; i < node->count; i++) {
+      AllocTraits::destroy(alloc_, data + i);
+    }
+    destroy_node(node);
+  }
+  size_ = 0;
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::steal_nodes(UnrolledList& list) {
+  if (list.size_ != 0) {
+    sentinel_.next = list.sentinel_.next;
+    sentinel_.prev = list.sentinel_.prev;
+    sentinel_.next->prev = &sentinel_;
+    sentinel_.prev->next = &sentinel_;
+    size_ = list.size_;
+  }
+  list.sentinel_.next = list.sentinel_.prev = &list.sentinel_;
+  list.size_ = 0;
+}
+
+template <typename T, size_t K, typename Allocator>
+void UnrolledList<T, K, Allocator>::swap_lists(UnrolledList& list) {
+  UnrolledList temporary(std::move(list));
+  list.steal_nodes(*this);
+  steal_nodes(temporary);
+  std::swap(alloc_, list.alloc_);
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include "deque.h"
+
+// Ops that WindowAggregator answers with a monotonic deque.
+struct WindowMin {
+  template <typename T>
+  const T& operator()(const T& lhs, const T& rhs) const {
+    return std::min(lhs, rhs);
+  }
+};
+struct WindowMax {
+  template <typename T>
+  const T& operator()(const T& lhs, const T& rhs) const {
+    return std::max(lhs, rhs);
+  }
+};
+
+// Sliding-window aggregate of any associative Op (commutativity is not
+// required) with the two-stacks trick: elements are pushed onto a "back"
+// stack that only keeps a running aggregate, and evicted from a "front"
+// stack that keeps suffix aggregates. When the front stack runs empty, the
+// back stack is flipped into it in one pass. push, evict and query are
+// amortized O(1) and Op is applied about three times per element.
+//
+// Every element carries a timestamp so that a time window can be expired
+// with expire_before(); count-based windows can ignore it.
+template <typename T, typename Op = std::plus<T>, typename Time = long long>
+class WindowAggregator {
+ public:
+  explicit WindowAggregator(Op op = Op()) : op_(std::move(op)) {}
+
+  void push(const T& value, Time time = Time());
+  // Batched ingest: all elements get the same timestamp.
+  template <typename InputIt>
+  void push_range(InputIt first, InputIt last, Time time = Time());
+
+  // Evicts the oldest element(s).
+  void evict();
+  void evict(size_t count);
+  // Evicts every element whose timestamp is earlier than `time`.
+  void expire_before(Time time);
+
+  [[nodiscard]] size_t size() const { return values_.size(); }
+  [[nodiscard]] bool empty() const { return values_.size() == 0; }
+
+  // Op folded over the window, oldest element first. The window must not be
+  // empty.
+  T query() const;
+
+ private:
+  Op op_;
+  Deque<T> values_;
+  Deque<Time> times_;
+  // front_aggregates_[i] = values_[i] op ... op values_[front size - 1]; the
+  // elements after the front part are folded into back_aggregate_.
+  Deque<T> front_aggregates_;
+  std::optional<T> back_aggregate_;
+
+  void fold_back(const T& value) {
+    if (back_aggregate_.has_value()) {
+      back_aggregate_ = op_(*back_aggregate_, value);
+    } else {
+      back_aggregate_ = value;
+    }
+  }
+  void flip();
+};
+
+template <typename T, typename Op, typename Time>
+void WindowAggregator<T, Op, Time>::push(const T& value, Time time) {
+  values_.push_back(value);
+  times_.push_back(time);
+  fold_back(value);
+}
+template <typename T, typename Op, typename Time>
+template <typename InputIt>
+void WindowAggregator<T, Op, Time>::push_range(InputIt first, InputIt last,
+                                               Time time) {
+  size_t size = values_.size();
+  values_.append_range(first, last);
+  times_.resize(values_.size(), time);
+  segmented::for_each(values_.begin() + size, values_.end(),
+                      [this](const T& value) { fold_back(value); });
+}
+
+template <typename T, typename Op, typename Time>
+void WindowAggregator<T, Op, Time>::flip() {
+  size_t count = values_.size();
+  front_aggregates_.reserve_front(count);
+  auto iter = values_.end();
+  T aggregate = *--iter;
+  front_aggregates_.push_front(aggregate);
+  while (iter != values_.begin()) {
+    aggregate = op_(*--iter, aggregate);
+    front_aggregates_.push_front(aggregate);
+  }
+  back_aggregate_.reset();
+}
+
+template <typename T, typename Op, typename Time>
+void WindowAggregator<T, Op, Time>::evict() {
+  if (front_aggregates_.size() == 0) {
+    flip();
+  }
+  front_aggregates_.pop_front();
+  values_.pop_front();
+  times_.pop_front();
+}
+template <typename T, typename Op, typename Time>
+void WindowAggregator<T, Op, Time>::evict(size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    evict();
+  }
+}
+template <typename T, typename Op, typename Time>
+void WindowAggregator<T, Op, Time>::expire_before(Time time) {
+  while (times_.size() > 0 and times_[0] < time) {
+    evict();
+  }
+}
+
+template <typename T, typename Op, typename Time>
+T WindowAggregator<T, Op, Time>::query() const {
+  if (front_aggregates_.size() == 0) {
+    return *back_aggregate_;
+  }
+  if (!back_aggregate_.has_value()) {
+    return front_aggregates_[0];
+  }
+  return op_(front_aggregates_[0], *back_aggregate_);
+}
+
+// Sliding-window min or max with a monotonic deque: only elements that can
+// still become the extreme are kept, in order, so the answer is always at
+// the front. Compare is std::less for min and std::greater for max.
+template <typename T, typename Compare, typename Time>
+class MonotonicWindow {
+ public:
+  explicit MonotonicWindow(Compare compare = Compare())
+      : compare_(std::move(compare)) {}
+
+  void push(const T& value, Time time = Time());
+  template <typename InputIt>
+  void push_range(InputIt first, InputIt last, Time time = Time());
+
+  void evict();
+  void evict(size_t count);
+  void expire_before(Time time);
+
+  [[nodiscard]] size_t size() const { return times_.size(); }
+  [[nodiscard]] bool empty() const { return times_.size() == 0; }
+
+  T query() const { return candidates_[0].first; }
+
+ private:
+  Compare compare_;
+  Deque<Time> times_;
+  // Candidates with their sequence numbers; pushed_ - size() is the
+  // sequence number of the oldest element in the window.
+  Deque<std::pair<T, size_t>> candidates_;
+  size_t pushed_{0};
+};
+
+template <typename T, typename Compare, typename Time>
+void MonotonicWindow<T, Compare, Time>::push(const T& value, Time time) {
+  while (candidates_.size() > 0 and
+         !compare_(candidates_[candidates_.size() - 1].first, value)) {
+    candidates_.pop_back();
+  }
+  candidates_.emplace_back(value, pushed_);
+  times_.push_back(time);
+  pushed_++;
+}
+template <typename T, typename Compare, typename Time>
+template <typename InputIt>
+void MonotonicWindow<T, Compare, Time>::push_range(InputIt first,
+                                                   InputIt last, Time time) {
+  for (; first != last; ++first) {
+    push(*first, time);
+  }
+}
+
+template <typename T, typename Compare, typename Time>
+void MonotonicWindow<T, Compare, Time>::evict() {
+  size_t oldest = pushed_ - times_.size();
+  if (candidates_[0].second == oldest) {
+    candidates_.pop_front();
+  }
+  times_.pop_front();
+}
+template <typename T, typename Compare, typename Time>
+void MonotonicWindow<T, Compare, Time>::evict(size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    evict();
+  }
+}
+template <typename T, typename Compare, typename Time>
+void MonotonicWindow<T, Compare, Time>::expire_before(Time time) {
+  while (times_.size() > 0 and times_[0] < time) {
+    evict();
+  }
+}
+
+template <typename T, typename Time>
+class WindowAggregator<T, WindowMin, Time>
+    : public MonotonicWindow<T, std::less<T>, Time> {
+ public:
+  explicit WindowAggregator(WindowMin = WindowMin()) {}
+};
+template <typename T, typename Time>
+class WindowAggregator<T, WindowMax, Time>
+    : public MonotonicWindow<T, std::greater<T>, Time> {
+ public:
+  explicit WindowAggregator(WindowMax = WindowMax()) {}
+};
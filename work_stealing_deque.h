@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "deque.h"
+
+// Chase-Lev work-stealing deque. The owner thread pushes and pops at the
+// back without contention; any number of thieves take elements from the
+// front with a single CAS on `top_`.
+//
+// Storage is Deque's block layout used as a ring: the map holds a power of
+// two block pointers and index i lives in block (i / kBase) & mask. When the
+// ring is full the map doubles and the live blocks are relinked into it, so
+// growing copies block pointers, never elements. Retired maps stay alive
+// until destruction because a thief may still be reading through one.
+//
+// Elements are read by thieves that may lose the race for them, so slots are
+// atomics and T must be trivially copyable (typically a task pointer).
+template <typename T, typename Allocator = std::allocator<T>,
+          typename BlockPolicy = DequeBlockPolicy<>>
+class WorkStealingDeque {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "WorkStealingDeque elements must be trivially copyable");
+
+  WorkStealingDeque();
+  WorkStealingDeque(const Allocator& alloc);
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+  ~WorkStealingDeque();
+
+  // Owner thread only.
+  void push_back(T value);
+  bool try_pop_back(T& value);
+
+  // Any thread.
+  bool try_steal(T& value);
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] bool empty() const;
+
+ private:
+  static constexpr long long kBase =
+      static_cast<long long>(BlockPolicy::template kElements<T>);
+  static constexpr size_t kCacheLine = 64;
+
+  struct alignas(BlockPolicy::template kAlignment<T>) Block {
+    std::atomic<T> slots[kBase];
+  };
+
+  struct Map {
+    Block** blocks;
+    size_t mask;
+    Map* retired;
+
+    std::atomic<T>& slot(long long index) const {
+      return blocks[(index / kBase) & mask]->slots[index % kBase];
+    }
+  };
+
+  using AllocTraits = std::allocator_traits<Allocator>;
+  using BlockAlloc = typename AllocTraits::template rebind_alloc<Block>;
+  using BlockTraits = std::allocator_traits<BlockAlloc>;
+  using MapAlloc = typename AllocTraits::template rebind_alloc<Map>;
+  using MapTraits = std::allocator_traits<MapAlloc>;
+  using PointerAlloc = typename AllocTraits::template rebind_alloc<Block*>;
+  using PointerTraits = std::allocator_traits<PointerAlloc>;
+
+  alignas(kCacheLine) std::atomic<long long> top_{0};
+  alignas(kCacheLine) std::atomic<long long> bottom_{0};
+  std::atomic<Map*> map_{nullptr};
+  Allocator alloc_;
+
+  Block* allocate_block() {
+    BlockAlloc block_alloc(alloc_);
+    Block* block = BlockTraits::allocate(block_alloc, 1);
+    BlockTraits::construct(block_alloc, block);
+    return block;
+  }
+  Map* allocate_map(size_t size, Map* retired) {
+    MapAlloc map_alloc(alloc_);
+    PointerAlloc pointer_alloc(alloc_);
+    Map* map = MapTraits::allocate(map_alloc, 1);
+    map->blocks = PointerTraits::allocate(pointer_alloc, size);
+    map->mask = size - 1;
+    map->retired = retired;
+    return map;
+  }
+  void deallocate_map(Map* map) {
+    MapAlloc map_alloc(alloc_);
+    PointerAlloc pointer_alloc(alloc_);
+    PointerTraits::deallocate(pointer_alloc, map->blocks, map->mask + 1);
+    MapTraits::deallocate(map_alloc, map, 1);
+  }
+
+  // Doubles the ring. The live blocks keep their block numbers, so every
+  // element stays where it is.
+  Map* grow(Map* map, long long top);
+};
+
+template <typename T, typename Allocator, typename BlockPolicy>
+WorkStealingDeque<T, Allocator, BlockPolicy>::WorkStealingDeque()
+    : WorkStealingDeque(Allocator()) {}
+template <typename T, typename Allocator, typename BlockPolicy>
+WorkStealingDeque<T, Allocator, BlockPolicy>::WorkStealingDeque(
+    const Allocator& alloc)
+    : alloc_(alloc) {
+  Map* map = allocate_map(1, nullptr);
+  map->blocks[0] = allocate_block();
+  map_.store(map, std::memory_order_relaxed);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+WorkStealingDeque<T, Allocator, BlockPolicy>::~WorkStealingDeque() {
+  Map* map = map_.load(std::memory_order_relaxed);
+  BlockAlloc block_alloc(alloc_);
+  for (size_t i = 0; i <= map->mask; i++) {
+    BlockTraits::destroy(block_alloc, map->blocks[i]);
+    BlockTraits::deallocate(block_alloc, map->blocks[i], 1);
+  }
+  while (map != nullptr) {
+    Map* retired = map->retired;
+    deallocate_map(map);
+    map = retired;
+  }
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+typename WorkStealingDeque<T, Allocator, BlockPolicy>::Map*
+WorkStealingDeque<T, Allocator, BlockPolicy>::grow(Map* map, long long top) {
+  size_t size = map->mask + 1;
+  Map* grown = allocate_map(size * 2, map);
+  // Growing is triggered when the block for `bottom` would wrap onto the
+  // block of `top`, so every old block is live and their numbers are
+  // top / kBase + [0, size).
+  long long first = top / kBase;
+  long long blocks = static_cast<long long>(size);
+  for (long long i = first; i < first + blocks; i++) {
+    grown->blocks[i & grown->mask] = map->blocks[i & map->mask];
+  }
+  for (long long i = first + blocks; i < first + 2 * blocks; i++) {
+    grown->blocks[i & grown->mask] = allocate_block();
+  }
+  map_.store(grown, std::memory_order_release);
+  return grown;
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+void WorkStealingDeque<T, Allocator, BlockPolicy>::push_back(T value) {
+  long long bottom = bottom_.load(std::memory_order_relaxed);
+  long long top = top_.load(std::memory_order_acquire);
+  Map* map = map_.load(std::memory_order_relaxed);
+  if (bottom / kBase - top / kBase > static_cast<long long>(map->mask)) {
+    map = grow(map, top);
+  }
+  map->slot(bottom).store(value, std::memory_order_relaxed);
+  bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+bool WorkStealingDeque<T, Allocator, BlockPolicy>::try_pop_back(T& value) {
+  long long bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Map* map = map_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long long top = top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return false;
+  }
+  value = map->slot(bottom).load(std::memory_order_relaxed);
+  if (top == bottom) {
+    // Last element: race the thieves for it.
+    bool won = top_.compare_exchange_strong(top, top + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+bool WorkStealingDeque<T, Allocator, BlockPolicy>::try_steal(T& value) {
+  long long top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long long bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return false;
+  }
+  Map* map = map_.load(std::memory_order_acquire);
+  value = map->slot(top).load(std::memory_order_relaxed);
+  return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed);
+}
+
+template <typename T, typename Allocator, typename BlockPolicy>
+size_t WorkStealingDeque<T, Allocator, BlockPolicy>::size() const {
+  long long bottom = bottom_.load(std::memory_order_acquire);
+  long long top = top_.load(std::memory_order_acquire);
+  return (bottom > top ? static_cast<size_t>(bottom - top) : 0);
+}
+template <typename T, typename Allocator, typename BlockPolicy>
+bool WorkStealingDeque<T, Allocator, BlockPolicy>::empty() const {
+  return size() == 0;
+}
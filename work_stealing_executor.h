@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "deque.h"
+#include "work_stealing_deque.h"
+
+// Small work-stealing thread pool. Every worker owns a WorkStealingDeque of
+// tasks: tasks spawned from a worker go to the back of its own deque and are
+// popped LIFO, idle workers steal the oldest tasks of a random victim, and
+// tasks submitted from outside the pool go through a shared injection queue.
+// Tasks must not throw.
+class WorkStealingExecutor {
+ public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingExecutor(
+      size_t threads = std::max(1u, std::thread::hardware_concurrency()));
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+  // Runs every task that is still queued, then joins the workers.
+  ~WorkStealingExecutor();
+
+  void submit(Task task);
+
+  // Runs one queued task on the calling thread, if there is any. Used to
+  // help while waiting instead of blocking a worker.
+  bool run_one();
+
+  [[nodiscard]] size_t workers() const { return queues_.size(); }
+
+ private:
+  using Queue = WorkStealingDeque<Task*>;
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  Deque<Task*> injected_;
+  std::atomic<size_t> pending_{0};
+  bool stop_{false};
+
+  // The pool and worker index of the worker running on this thread, if any.
+  static thread_local WorkStealingExecutor* owner;
+  static thread_local size_t worker_index;
+  static thread_local size_t steal_seed;
+
+  Task* find_task();
+  void run(Task* task);
+  void work(size_t index);
+};
+
+inline thread_local WorkStealingExecutor* WorkStealingExecutor::owner = nullptr;
+inline thread_local size_t WorkStealingExecutor::worker_index = 0;
+inline thread_local size_t WorkStealingExecutor::steal_seed = 0;
+
+inline WorkStealingExecutor::WorkStealingExecutor(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  for (size_t i = 0; i < threads; i++) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; i++) {
+    threads_.emplace_back([this, i] { work(i); });
+  }
+}
+
+inline WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+inline void WorkStealingExecutor::submit(Task task) {
+  Task* owned = new Task(std::move(task));
+  pending_.fetch_add(1, std::memory_order_release);
+  if (owner == this) {
+    queues_[worker_index]->push_back(owned);
+  } else {
+    std::lock_guard<std::mutex> lock(mutex_);
+    injected_.push_back(owned);
+  }
+  wake_.notify_one();
+}
+
+inline WorkStealingExecutor::Task* WorkStealingExecutor::find_task() {
+  Task* task = nullptr;
+  if (owner == this and queues_[worker_index]->try_pop_back(task)) {
+    return task;
+  }
+  size_t count = queues_.size();
+  steal_seed = steal_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  size_t victim = (steal_seed >> 33) % count;
+  for (size_t i = 0; i < count; i++) {
+    if (queues_[(victim + i) % count]->try_steal(task)) {
+      return task;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (injected_.size() > 0) {
+    task = injected_[0];
+    injected_.pop_front();
+  }
+  return task;
+}
+
+inline void WorkStealingExecutor::run(Task* task) {
+  std::unique_ptr<Task> owned(task);
+  (*owned)();
+  pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+inline bool WorkStealingExecutor::run_one() {
+  Task* task = find_task();
+  if (task == nullptr) {
+    return false;
+  }
+  run(task);
+  return true;
+}
+
+inline void WorkStealingExecutor::work(size_t index) {
+  owner = this;
+  worker_index = index;
+  steal_seed = index + 1;
+  while (true) {
+    if (run_one()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_ and pending_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+    // Tasks pushed to worker deques do not take the mutex, so the wait is
+    // bounded instead of relying on a notification that may have been
+    // missed.
+    wake_.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
+
+// Fork-join helper: run() spawns tasks on the executor, wait() returns once
+// all of them have finished, running queued tasks on the calling thread in
+// the meantime.
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingExecutor& executor) : executor_(executor) {}
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  ~TaskGroup() { wait(); }
+
+  template <typename Function>
+  void run(Function&& function) {
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    executor_.submit([this, function = std::forward<Function>(function)] {
+      function();
+      outstanding_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  void wait() {
+    while (outstanding_.load(std::memory_order_acquire) != 0) {
+      if (!executor_.run_one()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  WorkStealingExecutor& executor_;
+  std::atomic<size_t> outstanding_{0};
+};